@@ -2,6 +2,8 @@
  * Chu Pico Air Sensor
  * WHowe <github.com/whowechina>
  * 
+ * Digital sensors are scanned by PIO, analog sensors by a repeating timer
+ * running on core 1.
  */
 
 #include "air.h"
@@ -10,19 +12,50 @@
 #include <stdbool.h>
 
 #include "bsp/board.h"
+#include "pico/time.h"
 #include "hardware/gpio.h"
 #include "hardware/adc.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
 
-#include "board_defs.h"
+#include "air.pio.h"
 
-int calibrationCounter = 10;
-bool calibrated = false;
-uint16_t thresholds[6];
-uint16_t maxReadings[6];
+#include "board_defs.h"
+#include "config.h"
+#include "airfilter.h"
+#include "airsense.h"
+#include "event.h"
+#include "input.h"
 
 static const uint8_t IR_SENSOR_LIST[] = IR_SENSOR_PINS;
 static const uint8_t IR_LED_LIST[] = IR_LED_PINS;
 
+static volatile int held_light = -1;
+static volatile uint8_t air_frame = 0;
+
+static void filter_update_config()
+{
+    airfilter_config(chu_cfg->air.debounce_on, chu_cfg->air.debounce_off);
+}
+
+/* Every filtered frame goes out as it's made, changes to the event ring
+ * and the state to the input snapshot. Core 1 only, from air_update() or
+ * the scan timer, never both. */
+static void publish_frame(uint8_t frame)
+{
+    static uint8_t last = 0;
+
+    uint32_t now = time_us_32();
+    uint8_t changed = frame ^ last;
+    last = frame;
+    for (int i = 0; i < 6; i++) {
+        if (changed & (1 << i)) {
+            event_push(EVENT_RING_AIR, EVENT_AIR_KEY + i, frame & (1 << i), now);
+        }
+    }
+    input_publish_air(frame, now);
+}
+
 // Sets the output pins to switch the charlieplexed array of LEDs.
 // 0 is the bottom-most LED and 5 is the top-most
 void change_light(int light) {
@@ -94,126 +127,391 @@ void turnoff_light() {
     gpio_set_dir(IR_LED_LIST[2], 0);
 }
 
+#ifndef IR_SENSOR_ANALOG
+
+#define AIR_PIO pio1
+
+#define SCAN_RING_BITS 4
+#define SCAN_RING_SIZE (1 << SCAN_RING_BITS)
+#define SCAN_DMA_COUNT 0xffffffff
+
+static uint scan_sm;
+static int scan_dma;
+static uint32_t scan_ring[SCAN_RING_SIZE] __attribute__((aligned(SCAN_RING_SIZE * 4)));
+static uint32_t scan_consumed = 0;
+static uint8_t scan_raw = 0;
+
+static void scan_init()
+{
+    /* LEDs and sensors must be on consecutive pins, see air.pio */
+    uint led_base = IR_LED_LIST[0];
+    for (int i = 1; i < 3; i++) {
+        if (IR_LED_LIST[i] < led_base) {
+            led_base = IR_LED_LIST[i];
+        }
+    }
+
+    uint offset = pio_add_program(AIR_PIO, &air_scan_program);
+    scan_sm = pio_claim_unused_sm(AIR_PIO, true);
+    air_scan_program_init(AIR_PIO, scan_sm, offset, led_base,
+                          IR_SENSOR_LIST[0], AIR_LED_DELAY_US);
+
+    /* Keep copying frames from RX FIFO into a small ring */
+    scan_dma = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(scan_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, SCAN_RING_BITS + 2);
+    channel_config_set_dreq(&c, pio_get_dreq(AIR_PIO, scan_sm, false));
+    dma_channel_configure(scan_dma, &c, scan_ring, &AIR_PIO->rxf[scan_sm],
+                          SCAN_DMA_COUNT, true);
+}
+
+static void scan_hold(int light)
+{
+    static bool holding = false;
+
+    if (light >= 0) {
+        pio_sm_set_enabled(AIR_PIO, scan_sm, false);
+        for (int i = 0; i < 3; i++) {
+            gpio_set_function(IR_LED_LIST[i], GPIO_FUNC_SIO);
+        }
+        change_light(light);
+        holding = true;
+    } else if (holding) {
+        turnoff_light();
+        for (int i = 0; i < 3; i++) {
+            pio_gpio_init(AIR_PIO, IR_LED_LIST[i]);
+        }
+        pio_sm_set_enabled(AIR_PIO, scan_sm, true);
+        holding = false;
+    }
+}
+
+static void scan_start()
+{
+}
+
+static void scan_update_config()
+{
+}
+
+// Runs all frames captured since last call through the filter and out
+void air_update()
+{
+    if (!dma_channel_is_busy(scan_dma)) {
+        scan_consumed = 0;
+        dma_channel_set_trans_count(scan_dma, SCAN_DMA_COUNT, false);
+        dma_channel_set_write_addr(scan_dma, scan_ring, true);
+        return;
+    }
+
+    uint32_t produced = SCAN_DMA_COUNT - dma_channel_hw_addr(scan_dma)->transfer_count;
+    if (produced - scan_consumed > SCAN_RING_SIZE) {
+        scan_consumed = produced - SCAN_RING_SIZE;
+    }
+
+    for (; scan_consumed != produced; scan_consumed++) {
+        // sensors read low when the beam is blocked
+        uint32_t raw = scan_ring[scan_consumed % SCAN_RING_SIZE];
+        scan_raw = ~air_scan_decode(raw) & 0x3f;
+        air_frame = airfilter_step(scan_raw);
+        publish_frame(air_frame);
+    }
+}
+
 uint16_t get_value(int sensor) {
-  // Turn on light corresponding to read sensor
-  change_light(sensor);
+    if ((sensor < 0) || (sensor >= 6)) {
+        return 0;
+    }
+    return (scan_raw & (1 << sensor)) ? 0 : 1;
+}
+
+// How much the beam is blocked, 0 to 256
+static uint16_t blocked_weight(int sensor)
+{
+    return (air_frame & (1 << sensor)) ? 256 : 0;
+}
+
+uint16_t air_baseline(int sensor)
+{
+    return 0;
+}
+
+uint16_t air_threshold(int sensor, bool on)
+{
+    return 0;
+}
 
-  // Delay required because the read may occur faster than the physical light turning on
-  sleep_ms(AIR_LED_DELAY);
-  
-#ifndef IR_SENSOR_ANALOG
-  return gpio_get(IR_SENSOR_LIST[sensor]);
 #else
-  adc_select_input(IR_SENSOR_LIST[sensor]-26);
-  return adc_read();
-#endif
 
-  // Turn the lights off when we're done reading
-  turnoff_light();
+static repeating_timer_t scan_timer;
+
+/* ADC runs round-robin over the sensor channels and DMA keeps filling the
+ * ring, sample k always belongs to adc_channels[k % adc_channel_num]. */
+#define ADC_RING_BITS 8
+#define ADC_RING_SIZE (1 << ADC_RING_BITS)
+#define ADC_DMA_COUNT 0xffffffff
+#define ADC_SAMPLE_US 2 // 500ksps in total
+#define ADC_SETTLE_US (AIR_LED_DELAY_US / 2)
+#define ADC_SETTLE_SAMPLES (ADC_SETTLE_US / ADC_SAMPLE_US)
+
+static uint16_t adc_ring[ADC_RING_SIZE] __attribute__((aligned(ADC_RING_SIZE * 2)));
+static int adc_dma;
+static uint8_t adc_channels[4];
+static int adc_channel_num = 0;
+static uint8_t sensor_slot[6];
+static uint32_t adc_consumed = 0;
+
+static void adc_capture_start()
+{
+    adc_run(false);
+    dma_channel_abort(adc_dma);
+    while (!(adc_hw->cs & ADC_CS_READY_BITS)) {
+        tight_loop_contents();
+    }
+    adc_fifo_drain();
+
+    adc_select_input(adc_channels[0]);
+    adc_consumed = 0;
+    dma_channel_set_trans_count(adc_dma, ADC_DMA_COUNT, false);
+    dma_channel_set_write_addr(adc_dma, adc_ring, true);
+    adc_run(true);
 }
 
-void air_init(){
-    gpio_init(IR_LED_LIST[0]);
-    gpio_init(IR_LED_LIST[1]);
-    gpio_init(IR_LED_LIST[2]);
-	
+static void adc_capture_init()
+{
+    uint8_t mask = 0;
     for (int i = 0; i < 6; i++) {
-        maxReadings[i] = 0;
+        mask |= 1 << (IR_SENSOR_LIST[i] - 26);
+    }
+    for (int ch = 0; ch < 4; ch++) {
+        if (mask & (1 << ch)) {
+            adc_channels[adc_channel_num] = ch;
+            adc_channel_num++;
+        }
     }
-#ifndef IR_SENSOR_ANALOG
     for (int i = 0; i < 6; i++) {
-        gpio_init(IR_SENSOR_LIST[i]);
-        gpio_set_dir(IR_SENSOR_LIST[i], 0);
+        for (int slot = 0; slot < adc_channel_num; slot++) {
+            if (adc_channels[slot] == IR_SENSOR_LIST[i] - 26) {
+                sensor_slot[i] = slot;
+            }
+        }
     }
-#else
-	for (int i = 0; i < 6; i++) {
-        adc_gpio_init(IR_SENSOR_LIST[i]);
+
+    adc_set_round_robin(mask);
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv(0); // 500ksps in total
+
+    adc_dma = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(adc_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, ADC_RING_BITS + 1);
+    channel_config_set_dreq(&c, DREQ_ADC);
+    dma_channel_configure(adc_dma, &c, adc_ring, &adc_hw->fifo, 0, false);
+
+    adc_capture_start();
+}
+
+static void adc_discard()
+{
+    adc_consumed = ADC_DMA_COUNT - dma_channel_hw_addr(adc_dma)->transfer_count;
+}
+
+/* Averages the samples of each channel taken since last call, skipping
+ * the ones during LED settling. Returns bitmap of slots with new samples. */
+static uint8_t adc_collect(uint16_t avg[4])
+{
+    if (dma_channel_hw_addr(adc_dma)->transfer_count < ADC_RING_SIZE * 16) {
+        adc_capture_start();
+        return 0;
     }
+
+    uint32_t produced = ADC_DMA_COUNT - dma_channel_hw_addr(adc_dma)->transfer_count;
+    uint8_t got = airsense_average(adc_ring, ADC_RING_SIZE, adc_consumed, produced,
+                                   ADC_SETTLE_SAMPLES, adc_channel_num, avg);
+    adc_consumed = produced;
+    return got;
+}
+
+static uint16_t sample(int sensor)
+{
+    uint16_t avg[4];
+    uint8_t got = adc_collect(avg);
+    if (!got) {
+        return airsense_reading(sensor);
+    }
+
+#ifdef IR_SENSOR_DIFFERENTIAL
+    if (sensor == AIRSENSE_DARK_PHASE) {
+        for (int i = 0; i < 6; i++) {
+            int slot = sensor_slot[i];
+            if (got & (1 << slot)) {
+                airsense_dark(i, avg[slot]);
+            }
+        }
+        return 0;
+    }
+#endif
+
+    int slot = sensor_slot[sensor];
+    if (!(got & (1 << slot))) {
+        return airsense_reading(sensor);
+    }
+
+#ifdef IR_SENSOR_DIFFERENTIAL
+    // only the light from our own LED counts
+    return airsense_lit(sensor, avg[slot]);
+#else
+    return avg[slot];
 #endif
 }
 
-void analog_calibrate() {
-#ifdef IR_SENSOR_ANALOG
-  // Skip some samples, for some reason the first few readings tend to give wild values that can skew min/max tracking
-  for (int i = 0; i < SKIP_SAMPLES; i++) {
-    for (int sensor = 0; sensor < 6; sensor++) {
-      get_value(sensor);
+/* One LED phase per tick: the LED lit in the previous tick has been on for
+ * AIR_LED_DELAY_US by now. Samples of its first ADC_SETTLE_US are dropped
+ * while it settles, the rest are averaged for its sensor, then move to the
+ * next LED. Phases and frames are kept by airsense, change_light() turns
+ * all LEDs off for the dark phase. */
+static bool scan_tick(repeating_timer_t *rt)
+{
+    if (held_light >= 0) {
+        change_light(held_light);
+        airsense_scan_stop();
+        return true;
     }
-  }
 
-  // begin calibration
-  for (int i = 0; i < CALIBRATION_SAMPLES; i++) {
-    for (int sensor = 0; sensor < 6; sensor++) {
-      uint16_t value = get_value(sensor);
+    int phase = airsense_scan_phase();
+    if (phase < 0) {
+        adc_discard();
+        airsense_scan_start();
+    } else {
+        uint8_t frame;
+        if (airsense_scan_next(sample(phase), airfilter_state(), &frame)) {
+            air_frame = airfilter_step(frame);
+            publish_frame(air_frame);
+        }
+    }
+
+    change_light(airsense_scan_phase());
+    return true;
+}
+
+static void scan_init()
+{
+    adc_capture_init();
+}
+
+/* The alarm IRQ of a pool goes to the core that creates it, so the scan
+ * work stays off the core running USB and I2C. */
+static void scan_start()
+{
+    alarm_pool_t *pool = alarm_pool_create_with_unused_hardware_alarm(1);
+    airsense_scan_stop();
+    alarm_pool_add_repeating_timer_us(pool, -AIR_LED_DELAY_US, scan_tick,
+                                      NULL, &scan_timer);
+}
+
+static void scan_hold(int light)
+{
+}
+
+static void scan_update_config()
+{
+    airsense_update_thresholds();
+}
+
+void air_update()
+{
+}
 
-      if (value > maxReadings[sensor])
-        maxReadings[sensor] = value;
+// Averaged value of the sensor in last scan, it never blocks
+uint16_t get_value(int sensor) {
+    if ((sensor < 0) || (sensor >= 6)) {
+        return 0;
     }
+    return airsense_reading(sensor);
+}
 
-    // after sweeping the LEDs, scan the touchboard to simulate the delay between
-    // IR sweeps during actual gameplay so we calibrate accurately
-  }
+// How much the beam is blocked, 0 to 256, full at trigger level
+static uint16_t blocked_weight(int sensor)
+{
+    return airsense_weight(airsense_reading(sensor), airsense_baseline(sensor),
+                           airsense_threshold(sensor, true));
+}
 
-  for (int i = 0; i < 6; i++) {
-    thresholds[i] = (AIR_INPUT_DETECTION * maxReadings[i]);
-  }
-#endif
-calibrated = true;
+uint16_t air_baseline(int sensor)
+{
+    return airsense_baseline(sensor);
 }
 
-bool get_sensor_state(int sensor) {
-  uint16_t value = get_value(sensor);
+uint16_t air_threshold(int sensor, bool on)
+{
+    return airsense_threshold(sensor, on);
+}
+
+#endif
 
+void air_init(){
+    gpio_init(IR_LED_LIST[0]);
+    gpio_init(IR_LED_LIST[1]);
+    gpio_init(IR_LED_LIST[2]);
+	
 #ifndef IR_SENSOR_ANALOG
-  return value == 0 ? true : false;
+    for (int i = 0; i < 6; i++) {
+        gpio_init(IR_SENSOR_LIST[i]);
+        gpio_set_dir(IR_SENSOR_LIST[i], 0);
+    }
 #else
-  return value < thresholds[sensor];
+    adc_init();
+    for (int i = 0; i < 6; i++) {
+        adc_gpio_init(IR_SENSOR_LIST[i]);
+    }
 #endif
-}
 
-// Using data from air sensors, compute the height of the player's hand, from 0 (not present) to 1 (highest possible position).
-float get_hand_position() {
-  int highestTriggered = -1;
-  
-  for (int i = 0; i < 6; i++) {
-    if (get_sensor_state(i)) {
-      if ((i + 1) > highestTriggered) {
-        highestTriggered = i + 1;
-      }
-    }
-  }
+    airsense_init();
+    air_update_config();
+    scan_init();
+}
 
-  if (calibrated) {
-    return highestTriggered == -1 ? 0 : ((float) highestTriggered / 6.0f);
-  } else {
-    calibrationCounter--;
-    
-    if (calibrationCounter <= 0) {
-	  analog_calibrate();
-      calibrated = true;
-    }
+// Analog scan interrupts are taken by the calling core
+void air_start()
+{
+    scan_start();
+}
 
-    return 0;
-  }
+void air_update_config()
+{
+    filter_update_config();
+    scan_update_config();
 }
 
-uint8_t get_sensor_readings() {
-  uint8_t reading = 0;
+// Keeps one LED on for testing, scan stops until called with -1
+void air_hold_light(int light)
+{
+    held_light = light;
+    scan_hold(light);
+}
 
-  for (int i = 0; i < 6; i++) {
-    reading |= ((int) get_sensor_state(i) << i);
-  }
+bool get_sensor_state(int sensor) {
+    if ((sensor < 0) || (sensor >= 6)) {
+        return false;
+    }
+    return air_frame & (1 << sensor);
+}
 
-  if (calibrated) {
-    return reading;
-  } else {
-    calibrationCounter--;
-    
-    if (calibrationCounter <= 0) {
-	  analog_calibrate();
-      calibrated = true;
+/* Height of the player's hand, 0 (not present) to 255 (top-most sensor).
+ * Analog sensors give heights between sensor levels. */
+uint8_t get_hand_position() {
+    uint16_t weight[6];
+    for (int i = 0; i < 6; i++) {
+        weight[i] = blocked_weight(i);
     }
+    return airsense_height(air_frame, weight);
+}
 
-    return 0;
-  }
-}
\ No newline at end of file
+uint8_t get_sensor_readings() {
+    return air_frame;
+}
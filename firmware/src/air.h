@@ -13,9 +13,15 @@
 void change_light(int light);
 void turnoff_light();
 uint16_t get_value(int sensor);
+uint16_t air_baseline(int sensor);
+uint16_t air_threshold(int sensor, bool on);
 void air_init();
+void air_start();
+void air_hold_light(int light);
+void air_update();
+void air_update_config();
 bool get_sensor_state(int sensor);
-float get_hand_position();
+uint8_t get_hand_position();
 uint8_t get_sensor_readings();
 
 #endif
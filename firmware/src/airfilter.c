@@ -0,0 +1,63 @@
+/*
+ * Chu Pico Air Sensor Debounce
+ * WHowe <github.com/whowechina>
+ * 
+ * Bit-parallel debounce, bit i of every byte is sensor i. Counters are kept
+ * as 3 bit planes so all sensors are stepped with a few logic ops. A sensor
+ * flips after its debounce count + 1 consecutive disagreeing scans.
+ */
+
+#include "airfilter.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+static struct {
+    uint8_t state;
+    uint8_t count[3];
+    uint8_t on[3];
+    uint8_t off[3];
+} filter;
+
+// Debounce counts 0..7 of the 6 sensors, for turning on and off
+void airfilter_config(const uint8_t *debounce_on, const uint8_t *debounce_off)
+{
+    for (int bit = 0; bit < 3; bit++) {
+        uint8_t on = 0;
+        uint8_t off = 0;
+        for (int i = 0; i < 6; i++) {
+            on |= ((debounce_on[i] >> bit) & 1) << i;
+            off |= ((debounce_off[i] >> bit) & 1) << i;
+        }
+        filter.on[bit] = on;
+        filter.off[bit] = off;
+    }
+}
+
+uint8_t airfilter_step(uint8_t raw)
+{
+    uint8_t state = filter.state;
+    uint8_t diff = raw ^ state;
+    uint8_t c0 = filter.count[0] & diff;
+    uint8_t c1 = filter.count[1] & diff;
+    uint8_t c2 = filter.count[2] & diff;
+
+    uint8_t t0 = (filter.on[0] & ~state) | (filter.off[0] & state);
+    uint8_t t1 = (filter.on[1] & ~state) | (filter.off[1] & state);
+    uint8_t t2 = (filter.on[2] & ~state) | (filter.off[2] & state);
+
+    uint8_t reached = diff & ~((c0 ^ t0) | (c1 ^ t1) | (c2 ^ t2));
+    uint8_t inc = diff & ~reached;
+
+    filter.count[2] = (c2 ^ (c1 & c0 & inc)) & ~reached;
+    filter.count[1] = (c1 ^ (c0 & inc)) & ~reached;
+    filter.count[0] = (c0 ^ inc) & ~reached;
+    filter.state = state ^ reached;
+
+    return filter.state;
+}
+
+uint8_t airfilter_state()
+{
+    return filter.state;
+}
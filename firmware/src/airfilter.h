@@ -0,0 +1,16 @@
+/*
+ * Chu Pico Air Sensor Debounce
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef AIRFILTER_H
+#define AIRFILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+void airfilter_config(const uint8_t *debounce_on, const uint8_t *debounce_off);
+uint8_t airfilter_step(uint8_t raw);
+uint8_t airfilter_state();
+
+#endif
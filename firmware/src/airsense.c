@@ -0,0 +1,284 @@
+/*
+ * Chu Pico Air Sensing
+ * WHowe <github.com/whowechina>
+ * 
+ * Hardware independent part of the air sensors: analog scan sequencing,
+ * averaging, ambient light, baseline tracking and hand height. Integer
+ * math only.
+ */
+
+#include "airsense.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "board_defs.h"
+#include "config.h"
+
+/* How much a beam is blocked, 0 to 256, full at the on (trigger) level.
+ * level and base are analog readings, a lower level is more blocked. */
+uint16_t airsense_weight(uint16_t level, uint16_t base, uint16_t on)
+{
+    if ((base <= on) || (level >= base)) {
+        return 0;
+    }
+    if (level <= on) {
+        return 256;
+    }
+    return (uint32_t)(base - level) * 256 / (base - on);
+}
+
+/* Height of the hand, 0 (not present) to 255 (top-most sensor). The hand
+ * reaches up to the highest blocked sensor, its weight and the weight of
+ * the sensor above it move the height between sensor levels. With full
+ * or no weights it's (highest + 1) * 255 / 6, same as digital sensors. */
+uint8_t airsense_height(uint8_t frame, const uint16_t weight[6])
+{
+    frame &= 0x3f;
+    if (!frame) {
+        return 0;
+    }
+
+    int top = 5;
+    while (!(frame & (1 << top))) {
+        top--;
+    }
+
+    uint32_t level = top * 256 + weight[top];
+    if (top < 5) {
+        level += weight[top + 1];
+    }
+
+    uint32_t height = level * 255 / (6 * 256);
+    if (height > 255) {
+        height = 255;
+    }
+    return height ? height : 1;
+}
+
+/* ADC samples round-robin over the sensor channels into a ring, sample k
+ * is at ring[k % ring_size] and belongs to channel slot k % slots. Counts
+ * keep going up, ring_size must be a power of 2. Averages what came after
+ * consumed, except the first skip samples, only the newest ring_size are
+ * still in the ring. Returns bitmap of slots that got samples. */
+uint8_t airsense_average(const uint16_t *ring, uint32_t ring_size,
+                         uint32_t consumed, uint32_t produced, uint32_t skip,
+                         int slots, uint16_t avg[4])
+{
+    uint32_t start = consumed + skip;
+    if ((int32_t)(produced - start) <= 0) {
+        return 0;
+    }
+    if (produced - start > ring_size) {
+        start = produced - ring_size;
+    }
+
+    uint32_t sum[4] = {0};
+    uint32_t count[4] = {0};
+    for (uint32_t k = start; k != produced; k++) {
+        int slot = k % slots;
+        sum[slot] += ring[k % ring_size];
+        count[slot]++;
+    }
+
+    uint8_t got = 0;
+    for (int slot = 0; slot < slots; slot++) {
+        if (count[slot]) {
+            avg[slot] = sum[slot] / count[slot];
+            got |= 1 << slot;
+        }
+    }
+    return got;
+}
+
+/* The analog scan lights one LED per tick and takes the level of the one
+ * lit in the tick before, plus a dark phase in differential mode. A frame
+ * is done after the last phase. Phase is -1 while stopped, the tick after
+ * starting lights LED 0 with nothing to take yet. */
+#ifdef IR_SENSOR_DIFFERENTIAL
+#define SCAN_PHASES 7
+#else
+#define SCAN_PHASES 6
+#endif
+
+static struct {
+    int phase;
+    uint8_t building;
+    uint16_t readings[6];
+} scan = { .phase = -1 };
+
+void airsense_scan_stop()
+{
+    scan.phase = -1;
+}
+
+void airsense_scan_start()
+{
+    scan.phase = 0;
+    scan.building = 0;
+}
+
+// Phase lit now, 0..5 for LEDs, AIRSENSE_DARK_PHASE for none, -1 stopped
+int airsense_scan_phase()
+{
+    return scan.phase;
+}
+
+/* Takes the level of the phase lit since last tick and moves on. filtered
+ * is the debounced state for hysteresis, a blocked sensor releases at a
+ * higher level. Returns true with the raw frame when it's complete, the
+ * baselines are tracked with it too. */
+bool airsense_scan_next(uint16_t level, uint8_t filtered, uint8_t *frame)
+{
+    int phase = scan.phase;
+    if (phase < 0) {
+        return false;
+    }
+
+    if (phase < 6) {
+        scan.readings[phase] = level;
+        bool blocked = filtered & (1 << phase);
+        if (level < airsense_threshold(phase, !blocked)) {
+            scan.building |= 1 << phase;
+        }
+    }
+
+    scan.phase++;
+    if (scan.phase < SCAN_PHASES) {
+        return false;
+    }
+
+    *frame = scan.building;
+    airsense_track(scan.readings, scan.building);
+    scan.phase = 0;
+    scan.building = 0;
+    return true;
+}
+
+// Level of the sensor in last scan
+uint16_t airsense_reading(int sensor)
+{
+    if ((sensor < 0) || (sensor >= 6)) {
+        return 0;
+    }
+    return scan.readings[sensor];
+}
+
+/* Differential mode has a dark phase with all LEDs off in every frame,
+ * what a sensor sees then is ambient light, only the rest is from its LED.
+ * Ambient is taken once per frame, so it must change slowly compared to a
+ * frame (sunlight, stage lights, mains flicker). */
+static uint16_t ambient[6];
+
+void airsense_dark(int sensor, uint16_t level)
+{
+    ambient[sensor] = level;
+}
+
+uint16_t airsense_lit(int sensor, uint16_t level)
+{
+    return level > ambient[sensor] ? level - ambient[sensor] : 0;
+}
+
+/* Baseline is the untouched level of each sensor in 1/16 steps, it follows
+ * drift slowly while the beam is clear and freezes while it's blocked.
+ * Rising is faster so a hand present at boot doesn't pin it down. */
+#define BASELINE_FRAC 4
+#define BASELINE_INTERVAL 64 // scan frames between updates
+#define BASELINE_RISE_SHIFT 2
+#define BASELINE_FALL_SHIFT 8
+#define BASELINE_STUCK 500 // updates blocked before resync
+
+static struct {
+    bool seeded;
+    int frames;
+    uint32_t baselines[6];
+    uint16_t on_thresholds[6];
+    uint16_t off_thresholds[6];
+    uint16_t blocked_updates[6];
+} track;
+
+void airsense_init()
+{
+    memset(&scan, 0, sizeof(scan));
+    scan.phase = -1;
+    memset(ambient, 0, sizeof(ambient));
+    memset(&track, 0, sizeof(track));
+}
+
+static void update_threshold(int sensor)
+{
+    uint32_t base = track.baselines[sensor] >> BASELINE_FRAC;
+    track.on_thresholds[sensor] = base * chu_cfg->air.on_level[sensor] / 100;
+    track.off_thresholds[sensor] = base * chu_cfg->air.off_level[sensor] / 100;
+}
+
+// On and off levels follow the config
+void airsense_update_thresholds()
+{
+    for (int i = 0; i < 6; i++) {
+        update_threshold(i);
+    }
+}
+
+// Called with the readings and raw (unfiltered) bits of every scan frame
+void airsense_track(const uint16_t level[6], uint8_t frame)
+{
+    track.frames++;
+    if (!track.seeded) {
+        // Skip some frames, for some reason the first few readings tend to
+        // give wild values that can skew the tracking
+        if (track.frames < SKIP_SAMPLES) {
+            return;
+        }
+        for (int i = 0; i < 6; i++) {
+            track.baselines[i] = level[i] << BASELINE_FRAC;
+            update_threshold(i);
+        }
+        track.seeded = true;
+        track.frames = 0;
+        return;
+    }
+
+    if (track.frames < BASELINE_INTERVAL) {
+        return;
+    }
+    track.frames = 0;
+
+    for (int i = 0; i < 6; i++) {
+        int32_t target = level[i] << BASELINE_FRAC;
+        int32_t delta = target - (int32_t)track.baselines[i];
+
+        if (frame & (1 << i)) {
+            track.blocked_updates[i]++;
+            if (track.blocked_updates[i] < BASELINE_STUCK) {
+                continue;
+            }
+            // blocked for too long, it's more likely a baseline shift
+            track.baselines[i] = target;
+        } else if (delta > 0) {
+            track.baselines[i] += delta >> BASELINE_RISE_SHIFT;
+        } else {
+            track.baselines[i] -= (-delta) >> BASELINE_FALL_SHIFT;
+        }
+        track.blocked_updates[i] = 0;
+        update_threshold(i);
+    }
+}
+
+uint16_t airsense_baseline(int sensor)
+{
+    if ((sensor < 0) || (sensor >= 6)) {
+        return 0;
+    }
+    return track.baselines[sensor] >> BASELINE_FRAC;
+}
+
+uint16_t airsense_threshold(int sensor, bool on)
+{
+    if ((sensor < 0) || (sensor >= 6)) {
+        return 0;
+    }
+    return on ? track.on_thresholds[sensor] : track.off_thresholds[sensor];
+}
@@ -0,0 +1,37 @@
+/*
+ * Chu Pico Air Sensing
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef AIRSENSE_H
+#define AIRSENSE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AIRSENSE_DARK_PHASE 6
+
+void airsense_init();
+
+void airsense_scan_stop();
+void airsense_scan_start();
+int airsense_scan_phase();
+bool airsense_scan_next(uint16_t level, uint8_t filtered, uint8_t *frame);
+uint16_t airsense_reading(int sensor);
+
+uint8_t airsense_average(const uint16_t *ring, uint32_t ring_size,
+                         uint32_t consumed, uint32_t produced, uint32_t skip,
+                         int slots, uint16_t avg[4]);
+
+void airsense_dark(int sensor, uint16_t level);
+uint16_t airsense_lit(int sensor, uint16_t level);
+
+void airsense_update_thresholds();
+void airsense_track(const uint16_t level[6], uint8_t frame);
+uint16_t airsense_baseline(int sensor);
+uint16_t airsense_threshold(int sensor, bool on);
+
+uint16_t airsense_weight(uint16_t level, uint16_t base, uint16_t on);
+uint8_t airsense_height(uint8_t frame, const uint16_t weight[6]);
+
+#endif
@@ -0,0 +1,213 @@
+/*
+ * Chu Pico Slider Auto Tuning
+ * WHowe <github.com/whowechina>
+ * 
+ * Sweeps MPR121 filter settings measuring electrode noise, then has the
+ * player slide over every key to measure touch deltas, and picks filter
+ * and per key sensitivity. Runs a small step per call so USB keeps going.
+ */
+
+#include "autotune.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "pico/time.h"
+
+#include "config.h"
+#include "slider.h"
+#include "mpr121.h"
+
+#define KEY_NUM 32
+#define COMBO_NUM 16 // ffi x sfi
+#define SETTLE_US 200000
+#define SAMPLE_INTERVAL_US 4000
+#define SAMPLE_NUM 64
+#define TOUCH_US 10000000
+#define SENSE_MAX 9
+#define SENSE_MIN -9
+
+static enum {
+    IDLE = 0,
+    SETTLE,
+    NOISE,
+    TOUCH,
+} state = IDLE;
+
+static int combo;
+static int samples;
+static uint64_t next_time;
+static uint64_t touch_end;
+
+static uint16_t noise_peak[COMBO_NUM][KEY_NUM];
+static uint32_t noise_sum[COMBO_NUM];
+static uint16_t touch_delta[KEY_NUM];
+
+/* Combos are in order of response time, second filter samples dominate,
+ * so combo = sfi * 4 + ffi. Sample interval is kept. */
+static uint8_t combo_filter(int combo)
+{
+    int ffi = combo % 4;
+    int sfi = combo / 4;
+    return (ffi << 6) | (sfi << 4) | (chu_cfg->sense.filter & 0x07);
+}
+
+// Only tried on the chips, the config is left alone until done
+static void apply_combo(int combo)
+{
+    slider_filter_override(combo_filter(combo));
+}
+
+/* Fastest combo whose total noise is within 25% (plus one count per key)
+ * of the quietest one. */
+int autotune_pick_filter(const uint32_t *noise_sum, int num)
+{
+    uint32_t best = noise_sum[0];
+    for (int i = 1; i < num; i++) {
+        if (noise_sum[i] < best) {
+            best = noise_sum[i];
+        }
+    }
+
+    uint32_t limit = best + best / 4 + KEY_NUM;
+    for (int i = 0; i < num; i++) {
+        if (noise_sum[i] <= limit) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+/* Threshold in the middle of noise peak and touch delta gives the best
+ * margin both ways, then converted to sense steps. */
+int8_t autotune_pick_sense(int noise_peak, int touch_delta, int8_t global)
+{
+    int threshold = (noise_peak + touch_delta + 1) / 2;
+    int sense = MPR121_TOUCH_THRESHOLD_BASE - threshold - global;
+    if (sense > SENSE_MAX) {
+        sense = SENSE_MAX;
+    }
+    if (sense < SENSE_MIN) {
+        sense = SENSE_MIN;
+    }
+    return sense;
+}
+
+static void sample(uint16_t *peak)
+{
+    const uint16_t *raw = slider_raw();
+    const uint16_t *base = slider_baseline();
+    for (int i = 0; i < KEY_NUM; i++) {
+        int delta = base[i] - raw[i];
+        if (delta < 0) {
+            delta = -delta;
+        }
+        if (delta > peak[i]) {
+            peak[i] = delta;
+        }
+    }
+}
+
+static void finish()
+{
+    int best = autotune_pick_filter(noise_sum, COMBO_NUM);
+    chu_cfg->sense.filter = combo_filter(best);
+
+    int tuned = 0;
+    for (int i = 0; i < KEY_NUM; i++) {
+        if (touch_delta[i] <= noise_peak[best][i] * 2) {
+            continue; // not touched, or too weak to tell
+        }
+        chu_cfg->sense.keys[i] = autotune_pick_sense(noise_peak[best][i],
+                                                     touch_delta[i],
+                                                     chu_cfg->sense.global);
+        tuned++;
+    }
+
+    state = IDLE;
+    slider_filter_override(-1);
+    config_changed();
+    printf("Autotune done: filter %d, %d, %d, %d keys tuned.\n",
+           best % 4, best / 4, chu_cfg->sense.filter & 0x07, tuned);
+}
+
+void autotune_start()
+{
+    if (state != IDLE) {
+        return;
+    }
+    memset(noise_peak, 0, sizeof(noise_peak));
+    memset(noise_sum, 0, sizeof(noise_sum));
+    memset(touch_delta, 0, sizeof(touch_delta));
+    combo = 0;
+    apply_combo(combo);
+    next_time = time_us_64() + SETTLE_US;
+    state = SETTLE;
+    printf("Autotune: measuring noise, keep hands off the slider.\n");
+}
+
+void autotune_stop()
+{
+    if (state == IDLE) {
+        return;
+    }
+    state = IDLE;
+    slider_filter_override(-1);
+    printf("Autotune aborted.\n");
+}
+
+bool autotune_running()
+{
+    return state != IDLE;
+}
+
+void autotune_update()
+{
+    if (state == IDLE) {
+        return;
+    }
+
+    uint64_t now = time_us_64();
+    if (now < next_time) {
+        return;
+    }
+    next_time = now + SAMPLE_INTERVAL_US;
+
+    switch (state) {
+        case SETTLE:
+            samples = 0;
+            state = NOISE;
+            break;
+        case NOISE:
+            sample(noise_peak[combo]);
+            if (++samples < SAMPLE_NUM) {
+                break;
+            }
+            for (int i = 0; i < KEY_NUM; i++) {
+                noise_sum[combo] += noise_peak[combo][i];
+            }
+            combo++;
+            if (combo < COMBO_NUM) {
+                apply_combo(combo);
+                next_time = now + SETTLE_US;
+                state = SETTLE;
+                break;
+            }
+            apply_combo(autotune_pick_filter(noise_sum, COMBO_NUM));
+            touch_end = now + TOUCH_US;
+            state = TOUCH;
+            printf("Autotune: slide over every key, both rows, for 10 seconds.\n");
+            break;
+        case TOUCH:
+            sample(touch_delta);
+            if (now >= touch_end) {
+                finish();
+            }
+            break;
+        default:
+            state = IDLE;
+            break;
+    }
+}
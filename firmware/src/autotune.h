@@ -0,0 +1,20 @@
+/*
+ * Chu Pico Slider Auto Tuning
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+void autotune_start();
+void autotune_stop();
+bool autotune_running();
+void autotune_update();
+
+int autotune_pick_filter(const uint32_t *noise_sum, int num);
+int8_t autotune_pick_sense(int noise_peak, int touch_delta, int8_t global);
+
+#endif
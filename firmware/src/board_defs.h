@@ -8,18 +8,18 @@
 #define I2C_PORT i2c0
 #define I2C_SDA 4
 #define I2C_SCL 5
-#define I2C_FREQ 733*1000
+#define I2C_SPEEDS { 400*1000, 733*1000, 1000*1000 } // selectable, fastest last
+//#define MPR121_IRQ_PINS { 1, 2, 3 } // IRQ outputs of the 3 MPR121, if wired
 
 #define RGB_PIN 0
 #define RGB_ORDER GRB // or RGB
 
 //#define IR_SENSOR_ANALOG
+//#define IR_SENSOR_DIFFERENTIAL // analog only, subtracts ambient light
 #define IR_LED_PINS { 27, 26, 28 }
 #define IR_SENSOR_PINS { 16, 17, 18, 19, 20, 21 }
-#define AIR_LED_DELAY 125
-#define AIR_INPUT_DETECTION 0.90
-#define CALIBRATION_SAMPLES 200
-#define SKIP_SAMPLES 40
+#define AIR_LED_DELAY_US 50 // settle time of each LED phase
+#define SKIP_SAMPLES 400 // in scan frames
 
 #define NKRO_KEYMAP "azsxdcfv1q2w3e4r5t6y7u8igbhnjmk,/'.;[]"
 #else
@@ -7,9 +7,19 @@
 #include "pico/stdio.h"
 #include "pico/stdlib.h"
 
+#include "board_defs.h"
 #include "config.h"
 #include "air.h"
 #include "slider.h"
+#include "detect.h"
+#include "position.h"
+#include "event.h"
+#include "hist.h"
+#include "autotune.h"
+#include "mpr121.h"
+#include "sof.h"
+#include "report.h"
+#include "rgb.h"
 #include "save.h"
 #include "cli.h"
 
@@ -67,15 +77,59 @@ static void disp_sense()
 
 static void disp_hid()
 {
+    uint32_t sent, suppressed;
+    report_stat(&sent, &suppressed);
     printf("[HID]\n");
-    printf("  Joy: %s, NKRO: %s.\n", 
+    printf("  Joy: %s, NKRO: %s, Air height: %s.\n", 
            chu_cfg->hid.joy ? "on" : "off",
-           chu_cfg->hid.nkro ? "on" : "off" );
+           chu_cfg->hid.nkro ? "on" : "off",
+           chu_cfg->air.hid_height ? "on" : "off");
+    printf("  Joy reports sent: %lu, suppressed: %lu\n", sent, suppressed);
+
+    uint32_t presented, dropped, torn, skipped;
+    rgb_frame_stat(&presented, &dropped, &torn, &skipped);
+    printf("  LED frames presented: %lu, dropped: %lu, torn: %lu, skipped: %lu\n",
+           presented, dropped, torn, skipped);
+}
+
+static void disp_air()
+{
+    printf("[Air]\n");
+    printf("    Sensor   | 0 | 1 | 2 | 3 | 4 | 5 |\n");
+    printf("  ------------------------------------\n");
+    printf("    On %%     |");
+    for (int i = 0; i < 6; i++) {
+        printf("%3d|", chu_cfg->air.on_level[i]);
+    }
+    printf("\n    Off %%    |");
+    for (int i = 0; i < 6; i++) {
+        printf("%3d|", chu_cfg->air.off_level[i]);
+    }
+    printf("\n    Deb. on  |");
+    for (int i = 0; i < 6; i++) {
+        printf("%3d|", chu_cfg->air.debounce_on[i]);
+    }
+    printf("\n    Deb. off |");
+    for (int i = 0; i < 6; i++) {
+        printf("%3d|", chu_cfg->air.debounce_off[i]);
+    }
+    printf("\n");
+}
+
+static void disp_detect()
+{
+    printf("[Detect]\n");
+    printf("  Firmware detection: %s\n", chu_cfg->detect.enabled ? "on" : "off");
+    printf("  Level (on, off): %d, %d, Noise: x%d/4\n",
+           chu_cfg->detect.on_level, chu_cfg->detect.off_level,
+           chu_cfg->detect.noise_mult);
+    printf("  Tap (rise, hold): %d, %d ms\n",
+           chu_cfg->detect.tap_rise, chu_cfg->detect.tap_hold);
 }
 
 void handle_display(int argc, char *argv[])
 {
-    const char *usage = "Usage: display [colors|style|tof|sense|hid]\n";
+    const char *usage = "Usage: display [colors|style|tof|sense|hid|air|detect]\n";
     if (argc > 1) {
         printf(usage);
         return;
@@ -87,11 +141,13 @@ void handle_display(int argc, char *argv[])
         disp_tof();
         disp_sense();
         disp_hid();
+        disp_air();
+        disp_detect();
         return;
     }
 
-    const char *choices[] = {"colors", "style", "tof", "sense", "hid"};
-    switch (cli_match_prefix(choices, 5, argv[0])) {
+    const char *choices[] = {"colors", "style", "tof", "sense", "hid", "air", "detect"};
+    switch (cli_match_prefix(choices, 7, argv[0])) {
         case 0:
             disp_colors();
             break;
@@ -107,6 +163,12 @@ void handle_display(int argc, char *argv[])
         case 4:
             disp_hid();
             break;
+        case 5:
+            disp_air();
+            break;
+        case 6:
+            disp_detect();
+            break;
         default:
             printf(usage);
             break;
@@ -149,8 +211,80 @@ static void handle_level(int argc, char *argv[])
     disp_style();
 }
 
+// Slider key as 1A..16B, air sensor as air0..air5, returns event key
+static int extract_event_key(const char *param)
+{
+    int len = strlen(param);
+
+    if ((len > 3) && (strncasecmp(param, "air", 3) == 0)) {
+        int id = cli_extract_non_neg_int(param + 3, 0);
+        if ((id < 0) || (id > 5)) {
+            return -1;
+        }
+        return EVENT_AIR_KEY + id;
+    }
+
+    int offset;
+    if (toupper(param[len - 1]) == 'A') {
+        offset = 0;
+    } else if (toupper(param[len - 1]) == 'B') {
+        offset = 1;
+    } else {
+        return -1;
+    }
+
+    int id = cli_extract_non_neg_int(param, len - 1) - 1;
+    if ((id < 0) || (id > 15)) {
+        return -1;
+    }
+
+    return id * 2 + offset;
+}
+
+static void disp_hist(int key)
+{
+    printf("   Bucket   | Duration | Interval | Chatter\n");
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        uint32_t floor = hist_bucket_floor(b);
+        printf("  >=%4lu.%lums |", floor / 1000, floor % 1000 / 100);
+        for (int type = 0; type < HIST_TYPES; type++) {
+            printf(" %8u |", hist_get(key, type)[b]);
+        }
+        printf("\n");
+    }
+    printf("  Chatter window: %d ms\n", chu_cfg->stat.chatter_ms);
+}
+
 static void handle_stat(int argc, char *argv[])
 {
+    const char *usage = "Usage: stat [reset]\n"
+                        "       stat hist <key>\n"
+                        "       stat chatter <1..255>\n"
+                        "  key: 1A..16B or air0..air5\n";
+    if ((argc == 2) &&
+        (strncasecmp(argv[0], "hist", strlen(argv[0])) == 0)) {
+        int key = extract_event_key(argv[1]);
+        if (key < 0) {
+            printf(usage);
+            return;
+        }
+        disp_hist(key);
+        return;
+    }
+
+    if ((argc == 2) &&
+        (strncasecmp(argv[0], "chatter", strlen(argv[0])) == 0)) {
+        int ms = cli_extract_non_neg_int(argv[1], 0);
+        if ((ms < 1) || (ms > 255)) {
+            printf(usage);
+            return;
+        }
+        chu_cfg->stat.chatter_ms = ms;
+        config_changed();
+        printf("Chatter window: %d ms\n", ms);
+        return;
+    }
+
     if (argc == 0) {
         for (int col = 0; col < 4; col++) {
             printf(" %2dA |", col * 4 + 1);
@@ -166,14 +300,37 @@ static void handle_stat(int argc, char *argv[])
     } else if ((argc == 1) &&
                (strncasecmp(argv[0], "reset", strlen(argv[0])) == 0)) {
         slider_reset_stat();
+        hist_reset();
     } else {
-        printf("Usage: stat [reset]\n");
+        printf(usage);
     }
 }
 
 static void handle_hid(int argc, char *argv[])
 {
-    const char *usage = "Usage: hid <joy|nkro|both>\n";
+    const char *usage = "Usage: hid <joy|nkro|both>\n"
+                        "       hid height <on|off>\n"
+                        "       hid reset\n";
+    if ((argc == 1) &&
+        (strncasecmp(argv[0], "reset", strlen(argv[0])) == 0)) {
+        report_reset_stat();
+        disp_hid();
+        return;
+    }
+    if ((argc == 2) &&
+        (strncasecmp(argv[0], "height", strlen(argv[0])) == 0)) {
+        const char *onoff[] = {"on", "off"};
+        int match = cli_match_prefix(onoff, 2, argv[1]);
+        if (match < 0) {
+            printf(usage);
+            return;
+        }
+        chu_cfg->air.hid_height = (match == 0) ? 1 : 0;
+        config_changed();
+        disp_hid();
+        return;
+    }
+
     if (argc != 1) {
         printf(usage);
         return;
@@ -192,12 +349,33 @@ static void handle_hid(int argc, char *argv[])
     disp_hid();
 }
 
+static void update_sense()
+{
+    slider_update_config();
+    config_changed();
+    disp_sense();
+    printf("  Slider offline: %lu us\n", slider_offline_us());
+}
+
+// Autotune sweeps and then sets these, don't let them fight
+static bool tuning_locked()
+{
+    if (autotune_running()) {
+        printf("Autotune is running, \"autotune stop\" first.\n");
+        return true;
+    }
+    return false;
+}
+
 static void handle_filter(int argc, char *argv[])
 {
     const char *usage = "Usage: filter <first> <second> [interval]\n"
                         "    first: First iteration [0..3]\n"
                         "   second: Second iteration [0..3]\n"
                         " interval: Interval of second iterations [0..7]\n";
+    if (tuning_locked()) {
+        return;
+    }
     if ((argc < 2) || (argc > 3)) {
         printf(usage);
         return;
@@ -218,30 +396,17 @@ static void handle_filter(int argc, char *argv[])
 
     chu_cfg->sense.filter = (ffi << 6) | (sfi << 4) | intv;
 
-    slider_update_config();
-    config_changed();
-    disp_sense();
+    update_sense();
 }
 
 static int8_t *extract_key(const char *param)
 {
-    int len = strlen(param);
-
-    int offset;
-    if (toupper(param[len - 1]) == 'A') {
-        offset = 0;
-    } else if (toupper(param[len - 1]) == 'B') {
-        offset = 1;
-    } else {
+    int key = extract_event_key(param);
+    if ((key < 0) || (key >= EVENT_AIR_KEY)) {
         return NULL;
     }
 
-    int id = cli_extract_non_neg_int(param, len - 1) - 1;
-    if ((id < 0) || (id > 15)) {
-        return NULL;
-    }
-
-    return &chu_cfg->sense.keys[id * 2 + offset];
+    return &chu_cfg->sense.keys[key];
 }
 
 static void sense_do_op(int8_t *target, char op)
@@ -268,6 +433,9 @@ static void handle_sense(int argc, char *argv[])
                         "  >sense 1A +\n"
                         "  >sense 13B -\n"
                         "  >sense * 0\n";
+    if (tuning_locked()) {
+        return;
+    }
     if ((argc < 1) || (argc > 2)) {
         printf(usage);
         return;
@@ -296,15 +464,16 @@ static void handle_sense(int argc, char *argv[])
         }
     }
 
-    slider_update_config();
-    config_changed();
-    disp_sense();
+    update_sense();
 }
 
 static void handle_debounce(int argc, char *argv[])
 {
     const char *usage = "Usage: debounce <touch> [release]\n"
                         "  touch, release: 0..7\n";
+    if (tuning_locked()) {
+        return;
+    }
     if ((argc < 1) || (argc > 2)) {
         printf(usage);
         return;
@@ -328,9 +497,30 @@ static void handle_debounce(int argc, char *argv[])
     chu_cfg->sense.debounce_touch = touch;
     chu_cfg->sense.debounce_release = release;
 
-    slider_update_config();
-    config_changed();
-    disp_sense();
+    update_sense();
+}
+
+static void handle_autotune(int argc, char *argv[])
+{
+    const char *usage = "Usage: autotune [stop]\n"
+                        "  Sweeps filter settings for the least noise, then\n"
+                        "  sets sensitivity of each key touched in 10 seconds.\n";
+    if (argc == 0) {
+        if (autotune_running()) {
+            printf("Autotune is running.\n");
+            return;
+        }
+        autotune_start();
+        return;
+    }
+
+    if ((argc == 1) &&
+        (strncasecmp(argv[0], "stop", strlen(argv[0])) == 0)) {
+        autotune_stop();
+        return;
+    }
+
+    printf(usage);
 }
 
 static void handle_raw()
@@ -352,6 +542,7 @@ static void handle_airtest(int argc, char *argv[])
 {
     const char *usage = "Usage: led <0..5>\n";
     if (argc != 1) {
+        air_hold_light(-1);
         printf(usage);
         printf("Air sensor readings:\n");
         printf("%d", get_sensor_readings());
@@ -364,31 +555,298 @@ static void handle_airtest(int argc, char *argv[])
         printf(usage);
         return;
     }
-    turnoff_light();
-    if (led_on == 0) {
-        change_light(0);
-        printf("Air sensor 0 is on.\n");
+    air_hold_light(led_on);
+    printf("Air sensor %d is on.\n", led_on);
+}
+
+static void handle_airbase()
+{
+    printf("Air sensor baselines:\n");
+    printf("  Sensor | Level | Baseline |   On |  Off | State\n");
+    for (int i = 0; i < 6; i++) {
+        printf("  %6d | %5u | %8u | %4u | %4u | %s\n", i, get_value(i),
+               air_baseline(i), air_threshold(i, true),
+               air_threshold(i, false),
+               get_sensor_state(i) ? "blocked" : "clear");
+    }
+}
+
+static void handle_airfilter(int argc, char *argv[])
+{
+    const char *usage = "Usage: airfilter <0..5|*> <on> <off> [deb_on] [deb_off]\n"
+                        "          on, off: Trigger and release level [50..100]\n"
+                        "                   (%% of baseline, analog sensors only)\n"
+                        "  deb_on, deb_off: Debounce scans [0..7]\n";
+    if ((argc < 3) || (argc > 5)) {
+        printf(usage);
+        return;
     }
-    if (led_on == 1) {
-        change_light(1);
-        printf("Air sensor 1 is on.\n");
+
+    int first = 0;
+    int last = 5;
+    if (strcmp(argv[0], "*") != 0) {
+        first = cli_extract_non_neg_int(argv[0], 0);
+        last = first;
     }
-    if (led_on == 2) {
-        change_light(2);
-        printf("Air sensor 2 is on.\n");
+
+    int on = cli_extract_non_neg_int(argv[1], 0);
+    int off = cli_extract_non_neg_int(argv[2], 0);
+    int deb_on = (argc > 3) ? cli_extract_non_neg_int(argv[3], 0) : -2;
+    int deb_off = (argc > 4) ? cli_extract_non_neg_int(argv[4], 0) : -2;
+
+    if ((first < 0) || (first > 5) || (on < 50) || (on > off) ||
+        (off > 100) || (deb_on == -1) || (deb_on > 7) ||
+        (deb_off == -1) || (deb_off > 7)) {
+        printf(usage);
+        return;
     }
-    if (led_on == 3) {
-        change_light(3);
-        printf("Air sensor 3 is on.\n");
+
+    for (int i = first; i <= last; i++) {
+        chu_cfg->air.on_level[i] = on;
+        chu_cfg->air.off_level[i] = off;
+        if (deb_on >= 0) {
+            chu_cfg->air.debounce_on[i] = deb_on;
+        }
+        if (deb_off >= 0) {
+            chu_cfg->air.debounce_off[i] = deb_off;
+        }
+    }
+
+    air_update_config();
+    config_changed();
+    disp_air();
+}
+
+static void disp_detect_keys()
+{
+    printf("Key delta / on threshold:\n");
+    printf("    | 1| 2| 3| 4| 5| 6| 7| 8| 9|10|11|12|13|14|15|16|\n");
+    for (int row = 0; row < 2; row++) {
+        printf("  %c |", row ? 'B' : 'A');
+        for (int i = 0; i < 16; i++) {
+            printf("%2d|", detect_delta(i * 2 + row));
+        }
+        printf("\n    |");
+        for (int i = 0; i < 16; i++) {
+            printf("%2d|", detect_threshold(i * 2 + row, true));
+        }
+        printf("\n");
     }
-    if (led_on == 4) {
-        change_light(4);
-        printf("Air sensor 4 is on.\n");
+}
+
+static void handle_detect(int argc, char *argv[])
+{
+    const char *usage = "Usage: detect [on|off]\n"
+                        "       detect level <on> <off>\n"
+                        "       detect noise <mult>\n"
+                        "       detect tap <rise> <hold>\n"
+                        "  on, off: Delta levels, off < on [1..200]\n"
+                        "     mult: On level is at least noise * mult / 4 [0..64]\n"
+                        "     rise: Delta rise in one sample to catch taps, 0 to disable [0..200]\n"
+                        "     hold: Minimum touch time in ms [0..100]\n";
+    if (argc == 0) {
+        disp_detect();
+        disp_detect_keys();
+        return;
     }
-    if (led_on == 5) {
-        change_light(5);
-        printf("Air sensor 5 is on.\n");
+
+    const char *choices[] = {"on", "off", "level", "noise", "tap"};
+    int match = cli_match_prefix(choices, 5, argv[0]);
+    int expect[] = {1, 1, 3, 2, 3};
+    if ((match < 0) || (argc != expect[match])) {
+        printf(usage);
+        return;
     }
+
+    int a = (argc > 1) ? cli_extract_non_neg_int(argv[1], 0) : 0;
+    int b = (argc > 2) ? cli_extract_non_neg_int(argv[2], 0) : 0;
+
+    switch (match) {
+        case 0:
+        case 1:
+            chu_cfg->detect.enabled = (match == 0) ? 1 : 0;
+            break;
+        case 2:
+            if ((b < 1) || (a <= b) || (a > 200)) {
+                printf(usage);
+                return;
+            }
+            chu_cfg->detect.on_level = a;
+            chu_cfg->detect.off_level = b;
+            break;
+        case 3:
+            if ((a < 0) || (a > 64)) {
+                printf(usage);
+                return;
+            }
+            chu_cfg->detect.noise_mult = a;
+            break;
+        case 4:
+            if ((a < 0) || (a > 200) || (b < 0) || (b > 100)) {
+                printf(usage);
+                return;
+            }
+            chu_cfg->detect.tap_rise = a;
+            chu_cfg->detect.tap_hold = b;
+            break;
+    }
+
+    detect_update_config();
+    config_changed();
+    disp_detect();
+}
+
+static void handle_pos()
+{
+    uint16_t pos[POSITION_MAX];
+    int num = slider_positions(pos, POSITION_MAX);
+
+    printf("Finger positions (column 1..16):");
+    for (int i = 0; i < num; i++) {
+        printf(" %d.%02d", pos[i] / POSITION_SCALE + 1,
+               pos[i] % POSITION_SCALE * 100 / POSITION_SCALE);
+    }
+    printf(num ? "\n" : " none\n");
+
+    const int loops = 1000;
+    uint32_t start = time_us_32();
+    for (int i = 0; i < loops; i++) {
+        slider_positions(pos, POSITION_MAX);
+    }
+    uint32_t elapsed = time_us_32() - start;
+    printf("Cost: %lu ns per frame\n", elapsed * 1000 / loops);
+}
+
+static void handle_events(int argc, char *argv[])
+{
+    if ((argc == 1) &&
+        (strncasecmp(argv[0], "clear", strlen(argv[0])) == 0)) {
+        event_clear_history();
+        return;
+    }
+    if (argc != 0) {
+        printf("Usage: events [clear]\n");
+        return;
+    }
+
+    event_t events[32];
+    int num = event_history(events, 32);
+    printf("Recent events (time us, delta us, key, edge):\n");
+    for (int i = 0; i < num; i++) {
+        uint32_t delta = i ? events[i].time_us - events[i - 1].time_us : 0;
+        const event_t *e = &events[i];
+        if (e->key < EVENT_AIR_KEY) {
+            printf("  %10lu %8lu  %2d%c  %s\n", e->time_us, delta,
+                   e->key / 2 + 1, e->key % 2 ? 'B' : 'A',
+                   e->pressed ? "press" : "release");
+        } else {
+            printf("  %10lu %8lu  Air%d %s\n", e->time_us, delta,
+                   e->key - EVENT_AIR_KEY, e->pressed ? "press" : "release");
+        }
+    }
+    printf("Dropped: slider %lu, air %lu\n", event_dropped(EVENT_RING_SLIDER),
+           event_dropped(EVENT_RING_AIR));
+}
+
+static void i2c_set_speed(const char *param)
+{
+    const uint32_t speeds[] = I2C_SPEEDS;
+    int khz = cli_extract_non_neg_int(param, 0);
+    for (int i = 0; i < count_of(speeds); i++) {
+        if (speeds[i] / 1000 == khz) {
+            chu_cfg->i2c.speed = i + 1;
+            int used = slider_i2c_speed_apply();
+            config_changed();
+            if (used != i) {
+                printf("Self-test failed, fell back to %lu kHz.\n",
+                       speeds[used] / 1000);
+            }
+            return;
+        }
+    }
+    printf("Usage: i2c speed <400|733|1000>\n");
+}
+
+static void handle_i2c(int argc, char *argv[])
+{
+    const char *usage = "Usage: i2c [reset]\n"
+                        "       i2c speed <400|733|1000>\n";
+    if ((argc == 1) &&
+        (strncasecmp(argv[0], "reset", strlen(argv[0])) == 0)) {
+        mpr121_health_reset();
+        return;
+    }
+    if ((argc == 2) &&
+        (strncasecmp(argv[0], "speed", strlen(argv[0])) == 0)) {
+        i2c_set_speed(argv[1]);
+    } else if (argc != 0) {
+        printf(usage);
+        return;
+    }
+
+    printf("I2C speed: %lu kHz\n", slider_i2c_speed() / 1000);
+    printf("MPR121 I2C health:\n");
+    printf("  Addr | Transfers | Errors | Timeouts | Recover | Avg us | Max us | Autoconf | OOR\n");
+    for (int m = 0; m < 3; m++) {
+        const mpr121_health_t *health = mpr121_health(MPR121_ADDR + m);
+        if (!health) {
+            continue;
+        }
+        printf("  0x%02x | %9lu | %6lu | %8lu | %7lu | %6lu | %6lu | %8lu | %03x%s\n",
+               MPR121_ADDR + m, health->transfers, health->errors, health->timeouts,
+               health->recoveries, health->latency_avg_us,
+               health->latency_max_us, health->autoconfigs, health->last_oor,
+               health->fail_streak ? " failing" : "");
+    }
+}
+
+static void handle_rate()
+{
+    uint32_t period, poll, fresh;
+    slider_rates(&period, &poll, &fresh);
+    printf("Slider sample period: %lu us (%lu Hz)\n", period, 1000000 / period);
+    printf("  Polls: %lu/s, with new data: %lu/s\n", poll, fresh);
+}
+
+static void handle_sync(int argc, char *argv[])
+{
+    const char *usage = "Usage: sync [on|off] [offset]\n"
+                        "       sync reset\n"
+                        "  offset: Report time before next USB frame in us [50..900]\n";
+    if (argc > 2) {
+        printf(usage);
+        return;
+    }
+
+    if (argc > 0) {
+        const char *choices[] = {"on", "off", "reset"};
+        int match = cli_match_prefix(choices, 3, argv[0]);
+        int offset = chu_cfg->sof.offset_us;
+        if (argc == 2) {
+            offset = cli_extract_non_neg_int(argv[1], 0);
+        }
+        if ((match < 0) || ((match == 2) && (argc != 1)) ||
+            (offset < 50) || (offset > 900)) {
+            printf(usage);
+            return;
+        }
+        if (match == 2) {
+            sof_reset_stat();
+            return;
+        }
+        chu_cfg->sof.enabled = (match == 0) ? 1 : 0;
+        chu_cfg->sof.offset_us = offset;
+        sof_update_config();
+        config_changed();
+    }
+
+    const sof_stat_t *stat = sof_stat();
+    printf("[Frame Sync]\n");
+    printf("  Sync: %s, Offset: %d us\n", chu_cfg->sof.enabled ? "on" : "off",
+           chu_cfg->sof.offset_us);
+    printf("  Frames: %lu, Missed: %lu\n", stat->frames, stat->missed);
+    printf("  Input age at frame start (min/avg/max): %lu/%lu/%lu us\n",
+           stat->age_min_us, stat->age_avg_us, stat->age_max_us);
 }
 
 static void handle_save()
@@ -411,8 +869,17 @@ void commands_init()
     cli_register("filter", handle_filter, "Set pre-filter config.");
     cli_register("sense", handle_sense, "Set sensitivity config.");
     cli_register("debounce", handle_debounce, "Set debounce config.");
+    cli_register("autotune", handle_autotune, "Tune filter and sensitivity.");
     cli_register("raw", handle_raw, "Show key raw readings.");
     cli_register("airtest", handle_airtest, "Show air sensor readings.");
+    cli_register("airbase", handle_airbase, "Show air sensor baselines.");
+    cli_register("airfilter", handle_airfilter, "Set air sensor filter config.");
+    cli_register("detect", handle_detect, "Set firmware touch detection.");
+    cli_register("pos", handle_pos, "Show slider finger positions.");
+    cli_register("events", handle_events, "Show recent touch events.");
+    cli_register("i2c", handle_i2c, "Show I2C bus health.");
+    cli_register("rate", handle_rate, "Show slider sample and poll rates.");
+    cli_register("sync", handle_sync, "Set USB frame synced reports.");
     cli_register("save", handle_save, "Save config to flash.");
     cli_register("factory", handle_factory_reset, "Reset everything to default.");
 }
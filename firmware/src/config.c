@@ -42,6 +42,31 @@ static chu_cfg_t default_cfg = {
         .mode = 0,
         .virtual_aic = 0,
     },
+    .air = {
+        .on_level = { 90, 90, 90, 90, 90, 90 },
+        .off_level = { 93, 93, 93, 93, 93, 93 },
+        .debounce_on = { 1, 1, 1, 1, 1, 1 },
+        .debounce_off = { 2, 2, 2, 2, 2, 2 },
+        .hid_height = 0,
+    },
+    .detect = {
+        .enabled = 0,
+        .on_level = 16,
+        .off_level = 10,
+        .noise_mult = 16,
+        .tap_rise = 12,
+        .tap_hold = 20,
+    },
+    .stat = {
+        .chatter_ms = 30,
+    },
+    .i2c = {
+        .speed = 2,
+    },
+    .sof = {
+        .enabled = 0,
+        .offset_us = 250,
+    },
 };
 
 chu_runtime_t *chu_runtime;
@@ -57,8 +82,8 @@ static void config_loaded()
         chu_cfg->tof = default_cfg.tof;
         config_changed();
     }
-    if ((chu_cfg->sense.filter & 0x0f) > 3 ||
-        ((chu_cfg->sense.filter >> 4) & 0x0f) > 3) {
+    // ffi is bits 7..6, sfi bits 5..4 and esi bits 2..0, bit 3 is unused
+    if (chu_cfg->sense.filter & 0x08) {
         chu_cfg->sense.filter = default_cfg.sense.filter;
         config_changed();
     }
@@ -78,6 +103,46 @@ static void config_loaded()
         chu_cfg->sense.debounce_release = default_cfg.sense.debounce_release;
         config_changed();
     }
+    for (int i = 0; i < 6; i++) {
+        if ((chu_cfg->air.on_level[i] < 50) ||
+            (chu_cfg->air.on_level[i] > chu_cfg->air.off_level[i]) ||
+            (chu_cfg->air.off_level[i] > 100)) {
+            chu_cfg->air.on_level[i] = default_cfg.air.on_level[i];
+            chu_cfg->air.off_level[i] = default_cfg.air.off_level[i];
+            config_changed();
+        }
+        if ((chu_cfg->air.debounce_on[i] > 7) ||
+            (chu_cfg->air.debounce_off[i] > 7)) {
+            chu_cfg->air.debounce_on[i] = default_cfg.air.debounce_on[i];
+            chu_cfg->air.debounce_off[i] = default_cfg.air.debounce_off[i];
+            config_changed();
+        }
+    }
+    if (chu_cfg->air.hid_height > 1) {
+        chu_cfg->air.hid_height = default_cfg.air.hid_height;
+        config_changed();
+    }
+    if ((chu_cfg->detect.enabled > 1) || (chu_cfg->detect.on_level > 200) ||
+        (chu_cfg->detect.off_level < 1) ||
+        (chu_cfg->detect.off_level >= chu_cfg->detect.on_level) ||
+        (chu_cfg->detect.noise_mult > 64) || (chu_cfg->detect.tap_rise > 200) ||
+        (chu_cfg->detect.tap_hold > 100)) {
+        chu_cfg->detect = default_cfg.detect;
+        config_changed();
+    }
+    if (chu_cfg->stat.chatter_ms < 1) {
+        chu_cfg->stat = default_cfg.stat;
+        config_changed();
+    }
+    if ((chu_cfg->i2c.speed < 1) || (chu_cfg->i2c.speed > 3)) {
+        chu_cfg->i2c = default_cfg.i2c;
+        config_changed();
+    }
+    if ((chu_cfg->sof.enabled > 1) ||
+        (chu_cfg->sof.offset_us < 50) || (chu_cfg->sof.offset_us > 900)) {
+        chu_cfg->sof = default_cfg.sof;
+        config_changed();
+    }
 }
 
 void config_changed()
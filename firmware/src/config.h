@@ -42,6 +42,31 @@ typedef struct __attribute__((packed)) {
         uint8_t mode : 4;
         uint8_t virtual_aic : 4;
     } aime;
+    struct {
+        uint8_t on_level[6]; // % of baseline, analog sensors only
+        uint8_t off_level[6];
+        uint8_t debounce_on[6];
+        uint8_t debounce_off[6];
+        uint8_t hid_height; // hand height as joystick axis
+    } air;
+    struct {
+        uint8_t enabled; // firmware detection instead of MPR121 comparator
+        uint8_t on_level;
+        uint8_t off_level;
+        uint8_t noise_mult; // on level is at least noise * mult / 4
+        uint8_t tap_rise;
+        uint8_t tap_hold; // ms
+    } detect;
+    struct {
+        uint8_t chatter_ms; // retouch within this is chatter
+    } stat;
+    struct {
+        uint8_t speed; // 1-based index in I2C_SPEEDS
+    } i2c;
+    struct {
+        uint8_t enabled; // reports synced to USB start of frame
+        uint16_t offset_us; // snapshot this long before next frame
+    } sof;
 } chu_cfg_t;
 
 typedef struct {
@@ -0,0 +1,115 @@
+/*
+ * Chu Pico Touch Detection
+ * WHowe <github.com/whowechina>
+ * 
+ * Detects touches from MPR121 filtered data and baselines instead of its
+ * internal comparator. Integer math only, nothing hardware specific so it
+ * can also be fed with recorded traces.
+ */
+
+#include "detect.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "config.h"
+
+#define KEY_NUM 32
+#define MIN_THRESHOLD 2
+
+static struct {
+    int16_t delta;
+    uint16_t noise; // mean absolute delta while released, Q4
+    uint32_t press_time;
+    bool touched;
+} keys[KEY_NUM];
+
+static struct {
+    int on;
+    int hysteresis;
+    int noise_mult; // in quarters
+    int tap_rise;
+    uint32_t tap_hold_us;
+} param;
+
+void detect_init()
+{
+    memset(keys, 0, sizeof(keys));
+    detect_update_config();
+}
+
+void detect_update_config()
+{
+    param.on = chu_cfg->detect.on_level;
+    param.hysteresis = chu_cfg->detect.on_level - chu_cfg->detect.off_level;
+    param.noise_mult = chu_cfg->detect.noise_mult;
+    param.tap_rise = chu_cfg->detect.tap_rise;
+    param.tap_hold_us = chu_cfg->detect.tap_hold * 1000;
+}
+
+/* On threshold is the fixed level adjusted by sense config, raised when
+ * the key gets noisy. Off threshold keeps a fixed gap below it. */
+int detect_threshold(int key, bool on)
+{
+    if ((key < 0) || (key >= KEY_NUM)) {
+        return 0;
+    }
+
+    int level = param.on - chu_cfg->sense.global - chu_cfg->sense.keys[key];
+    int noisy = (keys[key].noise * param.noise_mult) >> 6;
+    if (noisy > level) {
+        level = noisy;
+    }
+    if (level < MIN_THRESHOLD + param.hysteresis) {
+        level = MIN_THRESHOLD + param.hysteresis;
+    }
+    return on ? level : level - param.hysteresis;
+}
+
+// baseline is 10-bit, same scale as filtered data
+void detect_key(int key, uint16_t filtered, uint16_t baseline, uint32_t now_us)
+{
+    if ((key < 0) || (key >= KEY_NUM)) {
+        return;
+    }
+
+    int delta = baseline - filtered;
+    int rise = delta - keys[key].delta;
+    keys[key].delta = delta;
+
+    int on = detect_threshold(key, true);
+    int off = detect_threshold(key, false);
+
+    if (!keys[key].touched) {
+        // a steep rise past off threshold is a tap too short to settle
+        bool tap = (param.tap_rise > 0) && (rise >= param.tap_rise) &&
+                   (delta >= off);
+        if ((delta >= on) || tap) {
+            keys[key].touched = true;
+            keys[key].press_time = now_us;
+        } else {
+            int level = (delta < 0 ? -delta : delta) << 4;
+            keys[key].noise += (level - keys[key].noise) >> 4;
+        }
+    } else if ((delta < off) &&
+               (now_us - keys[key].press_time >= param.tap_hold_us)) {
+        keys[key].touched = false;
+    }
+}
+
+bool detect_touched(int key)
+{
+    if ((key < 0) || (key >= KEY_NUM)) {
+        return false;
+    }
+    return keys[key].touched;
+}
+
+int detect_delta(int key)
+{
+    if ((key < 0) || (key >= KEY_NUM)) {
+        return 0;
+    }
+    return keys[key].delta;
+}
@@ -0,0 +1,19 @@
+/*
+ * Chu Pico Touch Detection
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef DETECT_H
+#define DETECT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+void detect_init();
+void detect_update_config();
+void detect_key(int key, uint16_t filtered, uint16_t baseline, uint32_t now_us);
+bool detect_touched(int key);
+int detect_delta(int key);
+int detect_threshold(int key, bool on);
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Chu Pico Input Events
+ * WHowe <github.com/whowechina>
+ * 
+ * Timestamped key transitions in single producer single consumer rings,
+ * no locks needed as long as each ring has one writer and one reader.
+ */
+
+#include "event.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hardware/sync.h"
+
+#define RING_SIZE 64 // power of 2
+#define HISTORY_SIZE 32
+
+static struct {
+    event_t buf[RING_SIZE];
+    volatile uint32_t head; // written by producer only
+    volatile uint32_t tail; // written by consumer only
+    uint32_t dropped;
+} rings[EVENT_RING_NUM];
+
+// Producer side, drops the event if the ring is full
+bool event_push(int ring, uint8_t key, bool pressed, uint32_t time_us)
+{
+    uint32_t head = rings[ring].head;
+    if (head - rings[ring].tail >= RING_SIZE) {
+        rings[ring].dropped++;
+        return false;
+    }
+
+    event_t *event = &rings[ring].buf[head % RING_SIZE];
+    event->key = key;
+    event->pressed = pressed;
+    event->time_us = time_us;
+    __dmb(); // event must be visible before head moves
+    rings[ring].head = head + 1;
+    return true;
+}
+
+// Consumer side
+bool event_pop(int ring, event_t *event)
+{
+    uint32_t tail = rings[ring].tail;
+    if (tail == rings[ring].head) {
+        return false;
+    }
+    __dmb();
+    *event = rings[ring].buf[tail % RING_SIZE];
+    __dmb(); // slot must be read before producer can reuse it
+    rings[ring].tail = tail + 1;
+    return true;
+}
+
+uint32_t event_dropped(int ring)
+{
+    return rings[ring].dropped;
+}
+
+/* History of consumed events for diagnosis, only touched by the consumer
+ * core so it needs no protection. */
+static event_t history[HISTORY_SIZE];
+static uint32_t history_count = 0;
+
+void event_log(const event_t *event)
+{
+    history[history_count % HISTORY_SIZE] = *event;
+    history_count++;
+}
+
+// Copies out most recent events, oldest first
+int event_history(event_t *events, int max)
+{
+    int num = history_count < HISTORY_SIZE ? history_count : HISTORY_SIZE;
+    if (num > max) {
+        num = max;
+    }
+    for (int i = 0; i < num; i++) {
+        events[i] = history[(history_count - num + i) % HISTORY_SIZE];
+    }
+    return num;
+}
+
+void event_clear_history()
+{
+    history_count = 0;
+}
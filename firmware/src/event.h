@@ -0,0 +1,35 @@
+/*
+ * Chu Pico Input Events
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef EVENT_H
+#define EVENT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define EVENT_AIR_KEY 32 // keys 0..31 are slider, 32..37 are air sensors
+#define EVENT_KEY_NUM 38
+
+enum {
+    EVENT_RING_SLIDER = 0, // produced on core 0
+    EVENT_RING_AIR,        // produced on core 1
+    EVENT_RING_NUM
+};
+
+typedef struct {
+    uint8_t key;
+    bool pressed;
+    uint32_t time_us;
+} event_t;
+
+bool event_push(int ring, uint8_t key, bool pressed, uint32_t time_us);
+bool event_pop(int ring, event_t *event);
+uint32_t event_dropped(int ring);
+
+void event_log(const event_t *event);
+int event_history(event_t *events, int max);
+void event_clear_history();
+
+#endif
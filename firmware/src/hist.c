@@ -0,0 +1,98 @@
+/*
+ * Chu Pico Touch Histograms
+ * WHowe <github.com/whowechina>
+ * 
+ * Per key log2 histograms of press duration, press interval and chatter,
+ * fed by input events. Constant memory, counters saturate.
+ */
+
+#include "hist.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "config.h"
+
+#define FIRST_BUCKET_BITS 9 // bucket 0 is below 512us
+
+static uint16_t hists[EVENT_KEY_NUM][HIST_TYPES][HIST_BUCKETS];
+
+static struct {
+    uint32_t press_time;
+    uint32_t release_time;
+    bool pressed;
+    bool released;
+} keys[EVENT_KEY_NUM];
+
+// Bucket b > 0 holds [256 << b, 512 << b) us, last one is open ended
+int hist_bucket(uint32_t us)
+{
+    if (us == 0) {
+        return 0;
+    }
+    int bits = 32 - __builtin_clz(us);
+    int bucket = bits - FIRST_BUCKET_BITS;
+    if (bucket < 0) {
+        return 0;
+    }
+    if (bucket >= HIST_BUCKETS) {
+        return HIST_BUCKETS - 1;
+    }
+    return bucket;
+}
+
+uint32_t hist_bucket_floor(int bucket)
+{
+    return bucket > 0 ? 256UL << bucket : 0;
+}
+
+static void count(int key, int type, uint32_t us)
+{
+    uint16_t *counter = &hists[key][type][hist_bucket(us)];
+    if (*counter < UINT16_MAX) {
+        (*counter)++;
+    }
+}
+
+void hist_feed(const event_t *event)
+{
+    int key = event->key;
+    if (key >= EVENT_KEY_NUM) {
+        return;
+    }
+
+    uint32_t now = event->time_us;
+    if (event->pressed) {
+        if (keys[key].pressed) {
+            count(key, HIST_INTERVAL, now - keys[key].press_time);
+        }
+        if (keys[key].released) {
+            uint32_t gap = now - keys[key].release_time;
+            if (gap < chu_cfg->stat.chatter_ms * 1000UL) {
+                count(key, HIST_CHATTER, gap);
+            }
+        }
+        keys[key].press_time = now;
+        keys[key].pressed = true;
+    } else if (keys[key].pressed) {
+        count(key, HIST_DURATION, now - keys[key].press_time);
+        keys[key].release_time = now;
+        keys[key].released = true;
+    }
+}
+
+const uint16_t *hist_get(int key, int type)
+{
+    if ((key < 0) || (key >= EVENT_KEY_NUM) ||
+        (type < 0) || (type >= HIST_TYPES)) {
+        return NULL;
+    }
+    return hists[key][type];
+}
+
+void hist_reset()
+{
+    memset(hists, 0, sizeof(hists));
+    memset(keys, 0, sizeof(keys));
+}
@@ -0,0 +1,29 @@
+/*
+ * Chu Pico Touch Histograms
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef HIST_H
+#define HIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "event.h"
+
+#define HIST_BUCKETS 16
+
+enum {
+    HIST_DURATION = 0, // press to release
+    HIST_INTERVAL,     // press to next press
+    HIST_CHATTER,      // release to retouch, within chatter window only
+    HIST_TYPES
+};
+
+void hist_feed(const event_t *event);
+int hist_bucket(uint32_t us);
+uint32_t hist_bucket_floor(int bucket);
+const uint16_t *hist_get(int key, int type);
+void hist_reset();
+
+#endif
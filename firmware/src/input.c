@@ -0,0 +1,72 @@
+/*
+ * Chu Pico Input Snapshot
+ * WHowe <github.com/whowechina>
+ * 
+ * Slider (core 0) and air (core 1) state published as one frame through a
+ * seqlock. Writers take a hardware spinlock so the sequence only moves in
+ * pairs, readers never block, they retry when a write got in between.
+ */
+
+#include "input.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hardware/sync.h"
+
+static input_t state;
+static volatile uint32_t seq = 0; // odd while being written
+static spin_lock_t *lock;
+
+void input_init()
+{
+    lock = spin_lock_init(spin_lock_claim_unused(true));
+}
+
+static uint32_t write_begin()
+{
+    uint32_t save = spin_lock_blocking(lock);
+    seq++;
+    __dmb(); // sequence must be odd before data changes
+    return save;
+}
+
+static void write_end(uint32_t save)
+{
+    __dmb(); // data must be complete before sequence is even again
+    seq++;
+    spin_unlock(lock, save);
+}
+
+void input_publish_touch(uint32_t touch, uint32_t now)
+{
+    uint32_t save = write_begin();
+    state.touch = touch;
+    state.touch_time_us = now;
+    write_end(save);
+}
+
+void input_publish_air(uint8_t air, uint32_t now)
+{
+    uint32_t save = write_begin();
+    state.air = air;
+    state.air_time_us = now;
+    write_end(save);
+}
+
+void input_read(input_t *input)
+{
+    while (true) {
+        uint32_t begin = seq;
+        if (begin & 1) {
+            tight_loop_contents();
+            continue;
+        }
+        __dmb();
+        *input = state;
+        __dmb();
+        if (seq == begin) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,24 @@
+/*
+ * Chu Pico Input Snapshot
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint32_t touch; // slider keys, bit 0 is 1A, bit 1 is 1B
+    uint8_t air; // air sensors
+    uint32_t touch_time_us; // when touch was last published
+    uint32_t air_time_us;
+} input_t;
+
+void input_init();
+void input_publish_touch(uint32_t touch, uint32_t now);
+void input_publish_air(uint8_t air, uint32_t now);
+void input_read(input_t *input);
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * Chu Pico LED Frame Handoff
+ * WHowe <github.com/whowechina>
+ * 
+ * Triple buffered frames. Colors are written to the back frame, presenting
+ * swaps it with the ready one, the driver swaps ready to front when it
+ * picks up a new frame. So the driver only ever sends complete frames and
+ * neither side waits for the other. Writers take turns on the back frame,
+ * one begin/end at a time.
+ */
+
+#include "ledframe.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "hardware/sync.h"
+
+static uint32_t frames[3][LED_NUM];
+static struct {
+    int back;
+    int ready;
+    int front;
+    bool fresh; // ready frame not yet picked up
+    int writer; // who is writing the back frame
+} swap = { 0, 1, 2, false, LEDFRAME_NONE };
+static spin_lock_t *swap_lock;
+
+static struct {
+    uint32_t presented;
+    uint32_t dropped; // replaced before the driver picked it up
+    uint32_t torn; // presented before all parts arrived
+    uint32_t skipped; // lost before arriving, by full frame sequence gaps
+} stat;
+
+void ledframe_init()
+{
+    swap_lock = spin_lock_init(spin_lock_claim_unused(true));
+}
+
+// Takes the back frame, false if the other writer is in the middle of it
+bool ledframe_begin(int writer)
+{
+    uint32_t save = spin_lock_blocking(swap_lock);
+    bool free = (swap.writer == LEDFRAME_NONE) || (swap.writer == writer);
+    if (free) {
+        swap.writer = writer;
+    }
+    spin_unlock(swap_lock, save);
+    return free;
+}
+
+void ledframe_end()
+{
+    uint32_t save = spin_lock_blocking(swap_lock);
+    swap.writer = LEDFRAME_NONE;
+    spin_unlock(swap_lock, save);
+}
+
+// Only between begin and end
+uint32_t *ledframe_back()
+{
+    return frames[swap.back];
+}
+
+// Only between begin and end
+void ledframe_present(bool complete)
+{
+    uint32_t save = spin_lock_blocking(swap_lock);
+    int done = swap.back;
+    swap.back = swap.ready;
+    swap.ready = done;
+    if (swap.fresh) {
+        stat.dropped++;
+    }
+    swap.fresh = true;
+    spin_unlock(swap_lock, save);
+
+    stat.presented++;
+    if (!complete) {
+        stat.torn++;
+    }
+
+    // reports update parts of a frame, so next frame starts from this one
+    memcpy(frames[swap.back], frames[done], sizeof(frames[0]));
+}
+
+// A presented frame is still waiting for the driver
+bool ledframe_pending()
+{
+    return swap.fresh;
+}
+
+// Driver side, the frame to send, a new one if presented since last call
+const uint32_t *ledframe_front()
+{
+    uint32_t save = spin_lock_blocking(swap_lock);
+    if (swap.fresh) {
+        int next = swap.ready;
+        swap.ready = swap.front;
+        swap.front = next;
+        swap.fresh = false;
+    }
+    spin_unlock(swap_lock, save);
+    return frames[swap.front];
+}
+
+/* Full frame reports may carry a sequence number, a small forward gap
+ * means frames were lost on the way, before they ever reached us. Same
+ * number again is a host not using it, anything else is a resync. */
+#define SEQ_MAX_GAP 16
+
+void ledframe_seq(uint8_t seq)
+{
+    static bool started = false;
+    static uint8_t last = 0;
+    uint8_t gap = seq - last;
+    if (started && (gap > 1) && (gap <= SEQ_MAX_GAP)) {
+        stat.skipped += gap - 1;
+    }
+    started = true;
+    last = seq;
+}
+
+void ledframe_stat(uint32_t *presented, uint32_t *dropped, uint32_t *torn,
+                   uint32_t *skipped)
+{
+    *presented = stat.presented;
+    *dropped = stat.dropped;
+    *torn = stat.torn;
+    *skipped = stat.skipped;
+}
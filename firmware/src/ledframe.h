@@ -0,0 +1,34 @@
+/*
+ * Chu Pico LED Frame Handoff
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef LEDFRAME_H
+#define LEDFRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define LED_NUM 47 // 16(Keys) + 15(Gaps) + 16(maximum ToF indicators)
+
+enum {
+    LEDFRAME_NONE = 0,
+    LEDFRAME_HOST, // LED reports from USB, core 0
+    LEDFRAME_IDLE, // light show while USB is quiet, core 1
+};
+
+void ledframe_init();
+
+bool ledframe_begin(int writer);
+void ledframe_end();
+uint32_t *ledframe_back();
+void ledframe_present(bool complete);
+bool ledframe_pending();
+
+const uint32_t *ledframe_front();
+
+void ledframe_seq(uint8_t seq);
+void ledframe_stat(uint32_t *presented, uint32_t *dropped, uint32_t *torn,
+                   uint32_t *skipped);
+
+#endif
@@ -32,28 +32,68 @@
 #include "air.h"
 #include "rgb.h"
 #include "lzfx.h"
+#include "event.h"
+#include "hist.h"
+#include "autotune.h"
+#include "sof.h"
+#include "report.h"
+#include "input.h"
 
 struct __attribute__((packed)) {
     uint16_t buttons; // 16 buttons; see JoystickButtons_t for bit mapping
     uint8_t  HAT;    // HAT switch; one nibble w/ unused nibble
     uint32_t axis;  // slider touch data
-    uint8_t  VendorSpec;
-} hid_joy;
+    uint8_t  air_height; // hand height, 0 when disabled
+} hid_joy, sent_hid_joy;
 
 struct __attribute__((packed)) {
     uint8_t modifier;
     uint8_t keymap[15];
 } hid_nkro, sent_hid_nkro;
 
-uint16_t air_cur = 0;
+static input_t input; // snapshot for current report
+
+/* Keys pressed since last report, so presses shorter than a report period
+ * still show up in at least one report. */
+static uint64_t key_latch = 0;
+
+static void consume_events()
+{
+    event_t event;
+    for (int ring = 0; ring < EVENT_RING_NUM; ring++) {
+        while (event_pop(ring, &event)) {
+            if (event.pressed) {
+                key_latch |= 1ULL << event.key;
+            }
+            event_log(&event);
+            hist_feed(&event);
+        }
+    }
+}
+
+static bool key_down(int key)
+{
+    if (key_latch & (1ULL << key)) {
+        return true;
+    }
+    if (key < EVENT_AIR_KEY) {
+        return input.touch & (1UL << key);
+    }
+    return input.air & (1 << (key - EVENT_AIR_KEY));
+}
 
 void report_usb_hid()
 {
     if (tud_hid_ready()) {
+        key_latch = 0;
         hid_joy.HAT = 0;
-        hid_joy.VendorSpec = 0;
         if (chu_cfg->hid.joy) {
-            tud_hid_n_report(0x00, REPORT_ID_JOYSTICK, &hid_joy, sizeof(hid_joy));
+            bool changed = memcmp(&hid_joy, &sent_hid_joy, sizeof(hid_joy)) != 0;
+            if (report_due(changed, time_us_64())) {
+                sent_hid_joy = hid_joy;
+                tud_hid_n_report(0x00, REPORT_ID_JOYSTICK, &sent_hid_joy,
+                                 sizeof(sent_hid_joy));
+            }
         }
         if (chu_cfg->hid.nkro &&
             (memcmp(&hid_nkro, &sent_hid_nkro, sizeof(hid_nkro)) != 0)) {
@@ -65,18 +105,27 @@ void report_usb_hid()
 
 static void gen_joy_report()
 {
+    input_read(&input);
+    consume_events();
+
     hid_joy.axis = 0;
     for (int i = 0; i < 16; i++) {
-        if (slider_touched(i * 2)) {
+        if (key_down(i * 2)) {
             hid_joy.axis |= 1 << (30 - i * 2);
         }
-        if (slider_touched(i * 2 + 1)) {
+        if (key_down(i * 2 + 1)) {
             hid_joy.axis |= 1 << (31 - i * 2);
         }
 
     }
     hid_joy.axis ^= 0x80808080; // some magic number from CrazyRedMachine
-    hid_joy.buttons = air_cur;
+    hid_joy.buttons = 0;
+    for (int i = 0; i < 6; i++) {
+        if (key_down(EVENT_AIR_KEY + i)) {
+            hid_joy.buttons |= 1 << i;
+        }
+    }
+    hid_joy.air_height = chu_cfg->air.hid_height ? get_hand_position() : 0;
 }
 
 const uint8_t keycode_table[128][2] = { HID_ASCII_TO_KEYCODE };
@@ -87,7 +136,7 @@ static void gen_nkro_report()
         uint8_t code = keycode_table[keymap[i]][1];
         uint8_t byte = code / 8;
         uint8_t bit = code % 8;
-        if (slider_touched(i)) {
+        if (key_down(i)) {
             hid_nkro.keymap[byte] |= (1 << bit);
         } else {
             hid_nkro.keymap[byte] &= ~(1 << bit);
@@ -112,23 +161,31 @@ static void run_lights()
     uint64_t now = time_us_64();
 
     if (now - last_hid_time >= 1000000) {
+        // at the driver's pace, and never in the middle of a USB frame
+        if (rgb_pending() || !rgb_begin(LEDFRAME_IDLE)) {
+            return;
+        }
         for (int i = 0; i < 15; i++) {
             uint32_t color = rgb32_from_hsv(i * 573 / 15, 255, 16);
             rgb_gap_color(i, color);
         }
 
+        input_t lights;
+        input_read(&lights);
         for (int i = 0; i < 16; i++) {
-            bool r = slider_touched(i * 2);
-            bool g = slider_touched(i * 2 + 1);
+            bool r = lights.touch & (1UL << (i * 2));
+            bool g = lights.touch & (1UL << (i * 2 + 1));
             rgb_set_color(30 - i * 2, rgb32(r ? 80 : 0, g ? 80 : 0, 0, false));
         }
+        rgb_present(true);
+        rgb_end();
     }
-
 }
 
 static mutex_t core1_io_lock;
 static void core1_loop()
 {
+    air_start();
     while (1) {
         if (mutex_try_enter(&core1_io_lock, NULL)) {
             run_lights();
@@ -136,11 +193,17 @@ static void core1_loop()
             mutex_exit(&core1_io_lock);
         }
         cli_fps_count(1);
-        air_cur = get_sensor_readings();
+        air_update();
         sleep_ms(1);
     }
 }
 
+// Needs TinyUSB 0.16+, only called while enabled by tud_sof_cb_enable()
+void tud_sof_cb(uint32_t frame_count)
+{
+    sof_frame(sof_time());
+}
+
 static void core0_loop()
 {
     while(1) {
@@ -152,10 +215,19 @@ static void core0_loop()
         cli_fps_count(0);
 
         slider_update();
+        autotune_update();
+
+        uint64_t now = time_us_64();
+        if (chu_cfg->sof.enabled && !sof_due(now)) {
+            continue;
+        }
 
         gen_joy_report();
         gen_nkro_report();
         report_usb_hid();
+        if (chu_cfg->sof.enabled) {
+            sof_submitted(input.touch_time_us, input.air_time_us);
+        }
     }
 }
 
@@ -168,6 +240,7 @@ void init()
     stdio_init_all();
 
     config_init();
+    input_init();
     mutex_init(&core1_io_lock);
     save_init(0xca34cafe, &core1_io_lock);
 
@@ -179,6 +252,8 @@ void init()
                             " https://github.com/whowechina\n\n");
     
     commands_init();
+    sof_init();
+    sof_update_config();
 }
 
 int main(void)
@@ -202,18 +277,80 @@ uint16_t tud_hid_get_report_cb(uint8_t itf, uint8_t report_id,
 
 // Invoked when received SET_REPORT control request or
 // received data on OUT endpoint ( Report ID = 0, Type = 0 )
+/* A full LED frame comes in one full frame report, or up to 3 output reports. The frame is presented
+ * once all parts the host sends have arrived. A part arriving again before
+ * that means a new frame has started, then what came so far is presented
+ * and the host is assumed to only send those parts from now on. */
+enum {
+    LED_PART_SLIDER_16 = 1,
+    LED_PART_SLIDER_15 = 2,
+    LED_PART_TOWER_6 = 4,
+};
+static uint8_t led_pending = 0;
+static uint8_t led_expect = LED_PART_SLIDER_16 | LED_PART_SLIDER_15 | LED_PART_TOWER_6;
+
+static void led_part(uint8_t part)
+{
+    if (led_pending & part) {
+        bool complete = (led_pending == led_expect);
+        led_expect = led_pending;
+        led_pending = 0;
+        rgb_present(complete);
+    }
+    led_pending |= part;
+}
+
+/* Some host stacks pad output reports to the largest one on the interface,
+ * so never take more LEDs than the report descriptor has. */
+static size_t led_num(uint16_t bufsize, size_t max)
+{
+    size_t num = bufsize / 3;
+    return num < max ? num : max;
+}
+
+// Idle light show only holds the frame for a few microseconds
+static void led_begin()
+{
+    while (!rgb_begin(LEDFRAME_HOST)) {
+        tight_loop_contents();
+    }
+}
+
+static void led_part_done()
+{
+    if ((led_pending & led_expect) == led_expect) {
+        led_expect = led_pending;
+        led_pending = 0;
+        rgb_present(true);
+    }
+}
+
 void tud_hid_set_report_cb(uint8_t itf, uint8_t report_id,
                            hid_report_type_t report_type, uint8_t const *buffer,
                            uint16_t bufsize)
 {
     if (report_type == HID_REPORT_TYPE_OUTPUT) {
+        led_begin();
         if (report_id == REPORT_ID_LED_SLIDER_16) {
-            rgb_set_brg(0, buffer, bufsize / 3);
+            led_part(LED_PART_SLIDER_16);
+            rgb_set_brg(0, buffer, led_num(bufsize, 16));
         } else if (report_id == REPORT_ID_LED_SLIDER_15) {
-            rgb_set_brg(16, buffer, bufsize / 3);
+            led_part(LED_PART_SLIDER_15);
+            rgb_set_brg(16, buffer, led_num(bufsize, 15));
         } else if (report_id == REPORT_ID_LED_TOWER_6) {
-            rgb_set_brg(31, buffer, bufsize / 3);
+            led_part(LED_PART_TOWER_6);
+            rgb_set_brg(31, buffer, led_num(bufsize, 6));
+        } else if ((report_id == REPORT_ID_LED_FRAME) && (bufsize > 1)) {
+            if (led_pending) {
+                rgb_present(false);
+            }
+            led_pending = 0;
+            rgb_frame_seq(buffer[0]);
+            rgb_set_brg(0, buffer + 1, led_num(bufsize - 1, 31 + 6));
+            rgb_present(true);
         }
+        led_part_done();
+        rgb_end();
         last_hid_time = time_us_64();
         return;
     } 
@@ -223,7 +360,10 @@ void tud_hid_set_report_cb(uint8_t itf, uint8_t report_id,
             uint8_t buf[(48 + 45 + 6) * 3];
             unsigned int olen = sizeof(buf);
             if (lzfx_decompress(buffer + 1, buffer[0], buf, &olen) == 0) {
+                led_begin();
                 rgb_set_brg(0, buf, olen / 3);
+                rgb_present(true);
+                rgb_end();
             }
 
             if (!chu_cfg->hid.joy) {
@@ -5,14 +5,18 @@
  */
 
 #include <stdint.h>
+#include <string.h>
+#include "hardware/gpio.h"
 #include "hardware/i2c.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
 
 #include "mpr121.h"
 #include "board_defs.h"
 
 #define IO_TIMEOUT_US 1000
 
-#define TOUCH_THRESHOLD_BASE 22
+#define TOUCH_THRESHOLD_BASE MPR121_TOUCH_THRESHOLD_BASE
 #define RELEASE_THRESHOLD_BASE 15
 
 #define MPR121_TOUCH_STATUS_REG 0x00
@@ -57,65 +61,319 @@
 #define MPR121_AUTOCONFIG_TARGET_REG 0x7F
 #define MPR121_SOFT_RESET_REG 0x80
 
-static void write_reg(uint8_t addr, uint8_t reg, uint8_t val)
+/* Each chip has a register image built in RAM and a shadow copy of what
+ * the chip holds. Only managed ranges are written, each with a single auto
+ * incremented transfer that covers the bytes differing from the shadow. */
+#define MAX_CHIPS 4
+#define REG_SPACE 0x80
+
+static const struct {
+    uint8_t start;
+    uint8_t end; // inclusive
+} managed[] = {
+    { MPR121_MAX_HALF_DELTA_RISING_REG, MPR121_FILTER_DELAY_COUNT_TOUCHED_REG },
+    { MPR121_TOUCH_THRESHOLD_REG, MPR121_FILTER_CONFIG_REG },
+    { MPR121_AUTOCONFIG_CONTROL_0_REG, MPR121_AUTOCONFIG_TARGET_REG },
+};
+
+static struct {
+    uint8_t addr;
+    uint8_t image[REG_SPACE];
+    uint8_t shadow[REG_SPACE];
+    bool running;
+    mpr121_health_t health;
+} chips[MAX_CHIPS];
+static int chip_num = 0;
+
+static int find_chip(uint8_t addr)
 {
+    for (int i = 0; i < chip_num; i++) {
+        if (chips[i].addr == addr) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Counts transaction result against the chip, result is bytes transferred
+ * or a PICO_ERROR code. Returns true on success. */
+static bool record(uint8_t addr, int result, int expected, uint64_t start)
+{
+    int id = find_chip(addr);
+    if (id < 0) {
+        return result == expected;
+    }
+
+    mpr121_health_t *health = &chips[id].health;
+    health->transfers++;
+    if (result != expected) {
+        if (result == PICO_ERROR_TIMEOUT) {
+            health->timeouts++;
+        } else {
+            health->errors++;
+        }
+        if (health->fail_streak < UINT8_MAX) {
+            health->fail_streak++;
+        }
+        return false;
+    }
+
+    int32_t latency = time_us_64() - start;
+    health->latency_avg_us += (latency - (int32_t)health->latency_avg_us) / 16;
+    if (latency > health->latency_max_us) {
+        health->latency_max_us = latency;
+    }
+    health->fail_streak = 0;
+    return true;
+}
+
+/* Asynchronous reads, one DMA driven transaction per chip. Transactions are
+ * chained by the RX DMA IRQ so core0 can service USB while the bus is busy.
+ * Target address can only change while I2C is disabled, so chips can't be
+ * chained in a single DMA sequence. */
+#define ASYNC_MAX_CHIPS 4
+#define ASYNC_MAX_LEN 48
+
+static struct {
+    int tx_dma;
+    int rx_dma;
+    uint8_t addrs[ASYNC_MAX_CHIPS];
+    int num;
+    int current;
+    uint8_t *buf;
+    int len;
+    uint32_t cmds[ASYNC_MAX_LEN + 1];
+    uint64_t start;
+    uint64_t deadline;
+    uint8_t failed;
+    volatile bool busy;
+} async;
+
+static void async_start_chip()
+{
+    i2c_hw_t *hw = i2c_get_hw(I2C_PORT);
+    hw->enable = 0;
+    hw->tar = async.addrs[async.current];
+    hw->enable = 1;
+    hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;
+
+    async.start = time_us_64();
+    async.deadline = async.start + IO_TIMEOUT_US * (1 + async.len / 2);
+    dma_channel_set_write_addr(async.rx_dma, async.buf + async.current * async.len, false);
+    dma_channel_set_trans_count(async.rx_dma, async.len, true);
+    dma_channel_set_read_addr(async.tx_dma, async.cmds, false);
+    dma_channel_set_trans_count(async.tx_dma, async.len + 1, true);
+}
+
+static void async_next()
+{
+    async.current++;
+    if (async.current < async.num) {
+        async_start_chip();
+        return;
+    }
+    i2c_get_hw(I2C_PORT)->dma_cr = 0;
+    async.busy = false;
+}
+
+static void async_irq_handler()
+{
+    if (!dma_channel_get_irq1_status(async.rx_dma)) {
+        return;
+    }
+    dma_channel_acknowledge_irq1(async.rx_dma);
+    if (async.busy) {
+        record(async.addrs[async.current], async.len, async.len, async.start);
+        async_next();
+    }
+}
+
+static void async_abort()
+{
+    i2c_hw_t *hw = i2c_get_hw(I2C_PORT);
+    dma_channel_abort(async.tx_dma);
+    dma_channel_abort(async.rx_dma);
+    dma_channel_acknowledge_irq1(async.rx_dma);
+    hw->dma_cr = 0;
+    (void)hw->clr_tx_abrt;
+    hw->enable = 0; // flushes the FIFOs
+    hw->enable = 1;
+}
+
+void mpr121_async_init()
+{
+    i2c_hw_t *hw = i2c_get_hw(I2C_PORT);
+    hw->dma_tdlr = 4;
+    hw->dma_rdlr = 0;
+
+    async.tx_dma = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(async.tx_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(I2C_PORT, true));
+    dma_channel_configure(async.tx_dma, &c, &hw->data_cmd, async.cmds, 0, false);
+
+    async.rx_dma = dma_claim_unused_channel(true);
+    c = dma_channel_get_default_config(async.rx_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, i2c_get_dreq(I2C_PORT, false));
+    dma_channel_configure(async.rx_dma, &c, NULL, &hw->data_cmd, 0, false);
+
+    dma_channel_set_irq1_enabled(async.rx_dma, true);
+    irq_add_shared_handler(DMA_IRQ_1, async_irq_handler,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+}
+
+/* Reads len bytes from reg of each chip, chip i goes to buf + i * len.
+ * Returns false if the engine is busy. */
+bool mpr121_read_async(const uint8_t *addrs, int num, uint8_t reg,
+                       uint8_t *buf, int len)
+{
+    if (mpr121_async_busy() || (num > ASYNC_MAX_CHIPS) ||
+        (len < 1) || (len > ASYNC_MAX_LEN)) {
+        return false;
+    }
+
+    memcpy(async.addrs, addrs, num);
+    async.num = num;
+    async.buf = buf;
+    async.len = len;
+
+    async.cmds[0] = reg;
+    for (int i = 0; i < len; i++) {
+        async.cmds[i + 1] = I2C_IC_DATA_CMD_CMD_BITS;
+    }
+    async.cmds[1] |= I2C_IC_DATA_CMD_RESTART_BITS;
+    async.cmds[len] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    async.current = 0;
+    async.failed = 0;
+    async.busy = true;
+    async_start_chip();
+    return true;
+}
+
+// Also moves on to the next chip if current one times out
+bool mpr121_async_busy()
+{
+    if (!async.busy) {
+        return false;
+    }
+
+    if (time_us_64() > async.deadline) {
+        irq_set_enabled(DMA_IRQ_1, false);
+        if (async.busy && (time_us_64() > async.deadline)) {
+            // aborted by NAK or lost arbitration, otherwise just stuck
+            bool abort = i2c_get_hw(I2C_PORT)->tx_abrt_source != 0;
+            record(async.addrs[async.current],
+                   abort ? PICO_ERROR_GENERIC : PICO_ERROR_TIMEOUT,
+                   async.len, async.start);
+            async_abort();
+            async.failed |= 1 << async.current;
+            async_next();
+        }
+        irq_set_enabled(DMA_IRQ_1, true);
+    }
+
+    return async.busy;
+}
+
+// Bitmap of chips (by index) failed in the last async read
+uint8_t mpr121_async_failed()
+{
+    return async.failed;
+}
+
+static void async_wait()
+{
+    while (mpr121_async_busy()) {
+        tight_loop_contents();
+    }
+}
+
+static bool write_reg(uint8_t addr, uint8_t reg, uint8_t val)
+{
+    async_wait();
     uint8_t buf[] = {reg, val};
-    i2c_write_blocking_until(I2C_PORT, addr, buf, 2, false,
-                             time_us_64() + IO_TIMEOUT_US);
+    uint64_t start = time_us_64();
+    int ret = i2c_write_blocking_until(I2C_PORT, addr, buf, 2, false,
+                                       start + IO_TIMEOUT_US);
+    return record(addr, ret, 2, start);
 }
 
-static uint8_t read_reg(uint8_t addr, uint8_t reg)
+static bool write_many(uint8_t addr, uint8_t reg, const uint8_t *vals, int num)
 {
-    uint8_t value;
-    i2c_write_blocking_until(I2C_PORT, addr, &reg, 1, true,
-                             time_us_64() + IO_TIMEOUT_US);
-    i2c_read_blocking_until(I2C_PORT, addr, &value, 1, false,
-                            time_us_64() + IO_TIMEOUT_US);
-    return value;
+    async_wait();
+    uint8_t buf[num + 1];
+    buf[0] = reg;
+    memcpy(buf + 1, vals, num);
+    uint64_t start = time_us_64();
+    int ret = i2c_write_blocking_until(I2C_PORT, addr, buf, num + 1, false,
+                                       start + IO_TIMEOUT_US * (1 + num / 2));
+    return record(addr, ret, num + 1, start);
 }
 
 void mpr121_init(uint8_t i2c_addr)
 {
+    int id = find_chip(i2c_addr);
+    if (id < 0) {
+        if (chip_num >= MAX_CHIPS) {
+            return;
+        }
+        id = chip_num++;
+    }
+    if (chips[id].addr == i2c_addr) {
+        chips[id].health.recoveries++; // initialized before
+    }
+    chips[id].addr = i2c_addr;
+    chips[id].running = false;
+    chips[id].health.fail_streak = 0;
+    uint8_t *img = chips[id].image;
+    memset(img, 0, REG_SPACE);
+
     write_reg(i2c_addr, 0x80, 0x63); // Soft reset MPR121 if not reset correctly 
 
     //touch pad baseline filter 
     //rising: baseline quick rising 
-    write_reg(i2c_addr, 0x2B, 1); // Max half delta Rising 
-    write_reg(i2c_addr, 0x2C, 1); // Noise half delta Rising 
-    write_reg(i2c_addr, 0x2D, 1); // Noise count limit Rising 
-    write_reg(i2c_addr, 0x2E, 1); // Delay limit Rising
+    img[0x2B] = 1; // Max half delta Rising 
+    img[0x2C] = 1; // Noise half delta Rising 
+    img[0x2D] = 1; // Noise count limit Rising 
+    img[0x2E] = 1; // Delay limit Rising
 
     //falling: baseline slow falling 
-    write_reg(i2c_addr, 0x2F, 1); // Max half delta Falling 
-    write_reg(i2c_addr, 0x30, 1); // Noise half delta Falling 
-    write_reg(i2c_addr, 0x31, 6); // Noise count limit Falling 
-    write_reg(i2c_addr, 0x32, 12); // Delay limit Falling
+    img[0x2F] = 1; // Max half delta Falling 
+    img[0x30] = 1; // Noise half delta Falling 
+    img[0x31] = 6; // Noise count limit Falling 
+    img[0x32] = 12; // Delay limit Falling
 
     //touched: baseline very slow falling
-    write_reg(i2c_addr, 0x33, 1); // Noise half delta Touched 
-    write_reg(i2c_addr, 0x34, 8); // Noise count Touched 
-    write_reg(i2c_addr, 0x35, 30); // Delay limit Touched 
+    img[0x33] = 1; // Noise half delta Touched 
+    img[0x34] = 8; // Noise count Touched 
+    img[0x35] = 30; // Delay limit Touched 
 
     //Touch pad threshold 
     for (int i = 0; i < 12; i++) {
-        write_reg(i2c_addr, 0x41 + i * 2, TOUCH_THRESHOLD_BASE);
-        write_reg(i2c_addr, 0x42 + i * 2, RELEASE_THRESHOLD_BASE);
+        img[0x41 + i * 2] = TOUCH_THRESHOLD_BASE;
+        img[0x42 + i * 2] = RELEASE_THRESHOLD_BASE;
     }
 
     //touch and release debounce 
-    write_reg(i2c_addr, 0x5B, 0x00);
+    img[0x5B] = 0x00;
 
     //AFE and filter configuration 
-    write_reg(i2c_addr, 0x5C, 0b00010000); // AFES=6 samples, same as AFES in 0x7B, Global CDC=16uA 
-    write_reg(i2c_addr, 0x5D, 0b00101000); // CT=0.5us, TDS=4samples, TDI=16ms 
-    write_reg(i2c_addr, 0x5E, 0x80); // Set baseline calibration enabled, baseline loading 5MSB 
+    img[0x5C] = 0b00010000; // AFES=6 samples, same as AFES in 0x7B, Global CDC=16uA 
+    img[0x5D] = 0b00101000; // CT=0.5us, TDS=4samples, TDI=16ms 
 
     //Auto Configuration 
-    write_reg(i2c_addr, 0x7B, 0b00001011); // AFES=6 samples, same as AFES in 0x5C 
+    img[0x7B] = 0b00001011; // AFES=6 samples, same as AFES in 0x5C 
     // retry=2b00, no retry, 
     // BVA=2b10, load 5MSB after AC, 
     // ARE/ACE=2b11, auto configuration enabled 
-    //write_reg(i2c_addr, 0x7C,0x80); // Skip charge time search, use setting in 0x5D, 
+    //img[0x7C] = 0x80; // Skip charge time search, use setting in 0x5D, 
     // OOR, AR, AC IE disabled 
     // Not used. Possible Proximity CDC shall over 63uA 
     // if only use 0.5uS CDT, the TGL for proximity cannot meet 
@@ -124,21 +382,39 @@ void mpr121_init(uint8_t i2c_addr)
 
     // I want to max out sensitivity, I don't care linearity
     const uint8_t usl = (3.3 - 0.1) / 3.3 * 256;
-    write_reg(i2c_addr, 0x7D, usl),  
-    write_reg(i2c_addr, 0x7E, usl * 0.65),
-    write_reg(i2c_addr, 0x7F, usl * 0.9);
+    img[0x7D] = usl;
+    img[0x7E] = usl * 0.65;
+    img[0x7F] = usl * 0.9;
 
-    write_reg(i2c_addr, 0x5E, 0x8C); // Run 12 touch, load 5MSB to baseline 
+    img[0x5E] = 0x8C; // Run 12 touch, load 5MSB to baseline 
+
+    // force all managed ranges to be written, chip is stopped after reset
+    for (int i = 0; i < REG_SPACE; i++) {
+        chips[id].shadow[i] = ~img[i];
+    }
+    mpr121_commit(i2c_addr);
 }
 
 #define ABS(x) ((x) < 0 ? -(x) : (x))
 
-static void mpr121_read_many(uint8_t addr, uint8_t reg, uint8_t *buf, int num)
+// Failed reads give zeros rather than garbage
+static bool mpr121_read_many(uint8_t addr, uint8_t reg, uint8_t *buf, int num)
 {
-    i2c_write_blocking_until(I2C_PORT, addr, &reg, 1, true,
-                             time_us_64() + IO_TIMEOUT_US);
-    i2c_read_blocking_until(I2C_PORT, addr, buf, num, false,
-                             time_us_64() + IO_TIMEOUT_US * num / 2);
+    async_wait();
+    uint64_t start = time_us_64();
+    int ret = i2c_write_blocking_until(I2C_PORT, addr, &reg, 1, true,
+                                       start + IO_TIMEOUT_US);
+    if (ret == 1) {
+        ret = i2c_read_blocking_until(I2C_PORT, addr, buf, num, false,
+                                      time_us_64() + IO_TIMEOUT_US * (1 + num / 2));
+    } else if (ret >= 0) {
+        ret = PICO_ERROR_GENERIC;
+    }
+    if (!record(addr, ret, num, start)) {
+        memset(buf, 0, num);
+        return false;
+    }
+    return true;
 }
 
 static void mpr121_read_many16(uint8_t addr, uint8_t reg, uint16_t *buf, int num)
@@ -162,49 +438,265 @@ void mpr121_raw(uint8_t addr, uint16_t *raw, int num)
     mpr121_read_many16(addr, MPR121_ELECTRODE_FILTERED_DATA_REG, raw, num);
 }
 
-static uint8_t mpr121_stop(uint8_t addr)
+// Baselines scaled to 10-bit like filtered data
+void mpr121_baseline(uint8_t addr, uint16_t *baseline, int num)
 {
-    uint8_t ecr = read_reg(addr, MPR121_ELECTRODE_CONFIG_REG);
-    write_reg(addr, MPR121_ELECTRODE_CONFIG_REG, ecr & 0xC0);
-    return ecr;
+    uint8_t vals[num];
+    mpr121_read_many(addr, MPR121_BASELINE_VALUE_REG, vals, num);
+    for (int i = 0; i < num; i++) {
+        baseline[i] = vals[i] << 2;
+    }
 }
 
-static void mpr121_resume(uint8_t addr, uint8_t ecr)
+/* Electrodes must be stopped while configuration registers are written,
+ * ECR comes from the image so no read back is needed. */
+static void mpr121_stop(int id)
 {
-    write_reg(addr, MPR121_ELECTRODE_CONFIG_REG, ecr);
+    uint8_t ecr = chips[id].image[MPR121_ELECTRODE_CONFIG_REG];
+    write_reg(chips[id].addr, MPR121_ELECTRODE_CONFIG_REG, ecr & 0xC0);
 }
 
-void mpr121_filter(uint8_t addr, uint8_t ffi, uint8_t sfi, uint8_t esi)
+static void mpr121_resume(int id, uint8_t ecr)
 {
-    uint8_t ecr = mpr121_stop(addr);
+    write_reg(chips[id].addr, MPR121_ELECTRODE_CONFIG_REG, ecr);
+    chips[id].shadow[MPR121_ELECTRODE_CONFIG_REG] = ecr;
+}
 
-    uint8_t afe = read_reg(addr, MPR121_AFE_CONFIG_REG);
-    write_reg(addr, MPR121_AFE_CONFIG_REG, (afe & 0x3f) | ffi << 6);
-    uint8_t acc = read_reg(addr, MPR121_AUTOCONFIG_CONTROL_0_REG);
-    write_reg(addr, MPR121_AUTOCONFIG_CONTROL_0_REG, (acc & 0x3f) | ffi << 6);
-    uint8_t fcr = read_reg(addr, MPR121_FILTER_CONFIG_REG);
-    write_reg(addr, MPR121_FILTER_CONFIG_REG,
-              (fcr & 0xe0) | ((sfi & 3) << 3) | esi);
+static int write_dirty(int id)
+{
+    uint8_t *img = chips[id].image;
+    uint8_t *shadow = chips[id].shadow;
+    int writes = 0;
+
+    for (int r = 0; r < count_of(managed); r++) {
+        int first = -1;
+        int last = -1;
+        for (int i = managed[r].start; i <= managed[r].end; i++) {
+            if (img[i] != shadow[i]) {
+                if (first < 0) {
+                    first = i;
+                }
+                last = i;
+            }
+        }
+        if (first < 0) {
+            continue;
+        }
+        if (write_many(chips[id].addr, first, img + first, last - first + 1)) {
+            memcpy(shadow + first, img + first, last - first + 1);
+        }
+        writes++;
+    }
+
+    return writes;
+}
+
+static bool is_dirty(int id)
+{
+    for (int r = 0; r < count_of(managed); r++) {
+        if (memcmp(chips[id].image + managed[r].start,
+                   chips[id].shadow + managed[r].start,
+                   managed[r].end - managed[r].start + 1) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Writes staged changes to the chip in a single stop/resume window, returns
+ * how long the electrodes were stopped in us, 0 if nothing changed.
+ * Once running, baselines are saved and written back while stopped, and the
+ * chip resumes with CL=00 so tracking continues from them. Auto-config is
+ * kept off on the wire then, otherwise it would rerun on resume and shift
+ * all readings. Its last results in 0x5F.. are untouched. */
+uint32_t mpr121_commit(uint8_t addr)
+{
+    int id = find_chip(addr);
+    if (id < 0) {
+        return 0;
+    }
+
+    uint8_t *img = chips[id].image;
+    uint8_t acc = img[MPR121_AUTOCONFIG_CONTROL_0_REG];
+    uint8_t ecr = img[MPR121_ELECTRODE_CONFIG_REG];
+    bool running = chips[id].running;
+    if (running) {
+        img[MPR121_AUTOCONFIG_CONTROL_0_REG] = acc & 0xfc; // ARE/ACE off
+        ecr &= 0x3f; // CL=00, keep current baseline
+    }
 
-    mpr121_resume(addr, ecr);
+    uint32_t offline = 0;
+    if (is_dirty(id)) {
+        uint8_t baseline[13];
+        uint64_t start = time_us_64();
+        mpr121_stop(id);
+        bool keep = running &&
+            mpr121_read_many(addr, MPR121_BASELINE_VALUE_REG, baseline, 13);
+        write_dirty(id);
+        if (keep) {
+            write_many(addr, MPR121_BASELINE_VALUE_REG, baseline, 13);
+        }
+        mpr121_resume(id, ecr);
+        offline = time_us_64() - start;
+        chips[id].running = true;
+    }
+
+    img[MPR121_AUTOCONFIG_CONTROL_0_REG] = acc;
+    return offline;
+}
+
+// Bit 0..11 for electrodes, bit 14 auto-reconfig fail, bit 15 autoconfig fail
+uint16_t mpr121_out_of_range(uint8_t addr)
+{
+    uint16_t oor;
+    mpr121_read_many16(addr, MPR121_OUT_OF_RANGE_STATUS_0_REG, &oor, 1);
+    return oor;
+}
+
+/* Autoconfig only runs on stop to run transition with ACE set, so it's
+ * enabled for this one resume, with baseline reloaded like at power up. */
+void mpr121_autoconfig(uint8_t addr)
+{
+    int id = find_chip(addr);
+    if (id < 0) {
+        return;
+    }
+
+    uint8_t *img = chips[id].image;
+    chips[id].health.last_oor = mpr121_out_of_range(addr);
+    chips[id].health.autoconfigs++;
+
+    mpr121_stop(id);
+    uint8_t acc = img[MPR121_AUTOCONFIG_CONTROL_0_REG];
+    if (write_reg(addr, MPR121_AUTOCONFIG_CONTROL_0_REG, acc)) {
+        chips[id].shadow[MPR121_AUTOCONFIG_CONTROL_0_REG] = acc;
+    }
+    mpr121_resume(id, img[MPR121_ELECTRODE_CONFIG_REG]);
+}
+
+void mpr121_filter(uint8_t addr, uint8_t ffi, uint8_t sfi, uint8_t esi)
+{
+    int id = find_chip(addr);
+    if (id < 0) {
+        return;
+    }
+    uint8_t *img = chips[id].image;
+
+    img[MPR121_AFE_CONFIG_REG] = (img[MPR121_AFE_CONFIG_REG] & 0x3f) | ffi << 6;
+    img[MPR121_AUTOCONFIG_CONTROL_0_REG] =
+        (img[MPR121_AUTOCONFIG_CONTROL_0_REG] & 0x3f) | ffi << 6;
+    img[MPR121_FILTER_CONFIG_REG] =
+        (img[MPR121_FILTER_CONFIG_REG] & 0xe0) | ((sfi & 3) << 3) | esi;
 }
 
 void mpr121_sense(uint8_t addr, int8_t sense, int8_t *sense_keys, int num)
 {
-    uint8_t ecr = mpr121_stop(addr);
+    int id = find_chip(addr);
+    if (id < 0) {
+        return;
+    }
+    uint8_t *img = chips[id].image;
+
     for (int i = 0; (i < num) && (i < 12); i++) {
         int8_t delta = sense + sense_keys[i];
-        write_reg(addr, MPR121_TOUCH_THRESHOLD_REG + i * 2,
-                        TOUCH_THRESHOLD_BASE - delta);
-        write_reg(addr, MPR121_RELEASE_THRESHOLD_REG + i * 2,
-                        RELEASE_THRESHOLD_BASE - delta / 2);
+        img[MPR121_TOUCH_THRESHOLD_REG + i * 2] = TOUCH_THRESHOLD_BASE - delta;
+        img[MPR121_RELEASE_THRESHOLD_REG + i * 2] = RELEASE_THRESHOLD_BASE - delta / 2;
     }
-    mpr121_resume(addr, ecr);
 }
 
 void mpr121_debounce(uint8_t addr, uint8_t touch, uint8_t release)
 {
-    uint8_t ecr = mpr121_stop(addr);
-    write_reg(addr, 0x5B, (release & 0x07) << 4 | (touch & 0x07));
-    mpr121_resume(addr, ecr);
+    int id = find_chip(addr);
+    if (id < 0) {
+        return;
+    }
+    chips[id].image[MPR121_DEBOUNCE_REG] = (release & 0x07) << 4 | (touch & 0x07);
+}
+
+/* Reads back thresholds to filter config and compares them with what was
+ * written, returns number of failed rounds. */
+int mpr121_selftest(uint8_t addr, int rounds)
+{
+    int id = find_chip(addr);
+    if (id < 0) {
+        return rounds;
+    }
+
+    const int first = MPR121_TOUCH_THRESHOLD_REG;
+    const int num = MPR121_FILTER_CONFIG_REG - first + 1;
+    int failed = 0;
+    for (int i = 0; i < rounds; i++) {
+        uint8_t buf[num];
+        if (!mpr121_read_many(addr, first, buf, num) ||
+            (memcmp(buf, chips[id].shadow + first, num) != 0)) {
+            failed++;
+        }
+    }
+    return failed;
+}
+
+const mpr121_health_t *mpr121_health(uint8_t addr)
+{
+    int id = find_chip(addr);
+    if (id < 0) {
+        return NULL;
+    }
+    return &chips[id].health;
+}
+
+void mpr121_health_reset()
+{
+    for (int i = 0; i < chip_num; i++) {
+        uint8_t streak = chips[i].health.fail_streak;
+        memset(&chips[i].health, 0, sizeof(chips[i].health));
+        chips[i].health.fail_streak = streak;
+    }
+}
+
+static void bus_release(uint pin, bool release)
+{
+    gpio_set_dir(pin, release ? GPIO_IN : GPIO_OUT);
+    busy_wait_us(5);
+}
+
+/* A chip stuck in the middle of a read holds SDA low, 9 SCL clocks let it
+ * shift out the byte, then a STOP resets its bus state. Pins are driven
+ * open drain style, only low or released to pull-up. */
+void mpr121_bus_recover(uint32_t baudrate)
+{
+    async_wait();
+    i2c_deinit(I2C_PORT);
+
+    const uint pins[] = { I2C_SDA, I2C_SCL };
+    for (int i = 0; i < 2; i++) {
+        gpio_init(pins[i]);
+        gpio_pull_up(pins[i]);
+        gpio_put(pins[i], 0);
+        bus_release(pins[i], true);
+    }
+
+    for (int i = 0; i < 9; i++) {
+        bus_release(I2C_SCL, false);
+        bus_release(I2C_SCL, true);
+    }
+
+    bus_release(I2C_SCL, false);
+    bus_release(I2C_SDA, false);
+    bus_release(I2C_SCL, true);
+    bus_release(I2C_SDA, true);
+
+    i2c_init(I2C_PORT, baudrate);
+    gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
+    gpio_set_function(I2C_SCL, GPIO_FUNC_I2C);
+
+    i2c_hw_t *hw = i2c_get_hw(I2C_PORT);
+    hw->dma_tdlr = 4;
+    hw->dma_rdlr = 0;
+}
+
+// Changing speed disables the block, so the async read in flight goes first
+uint32_t mpr121_set_baudrate(uint32_t baudrate)
+{
+    async_wait();
+    return i2c_set_baudrate(I2C_PORT, baudrate);
 }
@@ -7,12 +7,46 @@
 #ifndef MP121_H
 #define MP121_H
 
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MPR121_ADDR 0x5A // ADDR pin to GND, next ones are +1, +2, +3
+#define MPR121_TOUCH_THRESHOLD_BASE 22 // at sense 0
+
+typedef struct {
+    uint32_t transfers;
+    uint32_t errors; // NAK or short transfer
+    uint32_t timeouts;
+    uint32_t recoveries;
+    uint32_t latency_avg_us;
+    uint32_t latency_max_us;
+    uint8_t fail_streak; // consecutive failed transfers
+    uint32_t autoconfigs; // reruns for out of range electrodes
+    uint16_t last_oor; // out of range status that caused last rerun
+} mpr121_health_t;
+
 void mpr121_init(uint8_t addr);
 
 uint16_t mpr121_touched(uint8_t addr);
 void mpr121_raw(uint8_t addr, uint16_t *raw, int num);
+void mpr121_baseline(uint8_t addr, uint16_t *baseline, int num);
 void mpr121_filter(uint8_t addr, uint8_t ffi, uint8_t sfi, uint8_t esi);
 void mpr121_sense(uint8_t addr, int8_t sense, int8_t *sense_keys, int num);
 void mpr121_debounce(uint8_t addr, uint8_t touch, uint8_t release);
+uint32_t mpr121_commit(uint8_t addr);
+
+void mpr121_async_init();
+bool mpr121_read_async(const uint8_t *addrs, int num, uint8_t reg,
+                       uint8_t *buf, int len);
+bool mpr121_async_busy();
+uint8_t mpr121_async_failed();
+
+uint16_t mpr121_out_of_range(uint8_t addr);
+void mpr121_autoconfig(uint8_t addr);
+int mpr121_selftest(uint8_t addr, int rounds);
+const mpr121_health_t *mpr121_health(uint8_t addr);
+void mpr121_health_reset();
+void mpr121_bus_recover(uint32_t baudrate);
+uint32_t mpr121_set_baudrate(uint32_t baudrate);
 
 #endif
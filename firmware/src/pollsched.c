@@ -0,0 +1,82 @@
+/*
+ * Chu Pico Slider Poll Scheduling
+ * WHowe <github.com/whowechina>
+ * 
+ * Decides which MPR121 chips to read and when, no hardware access here.
+ */
+
+#include "pollsched.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* MPR121 has new data once every electrode sample interval (ESI). A read
+ * finding new data schedules the next one a bit less than a period later,
+ * so reads creep earlier until one finds nothing new, that one retries
+ * after 1/8 period. Reads then stay within 1/8 period after each sample,
+ * however long they take and even if the chip clock is off a little.
+ * Times are when reads were queued. */
+static struct {
+    uint32_t period_us;
+    uint64_t next_us;
+    uint64_t window_us;
+    uint32_t polls;
+    uint32_t fresh;
+    uint32_t poll_rate; // per second
+    uint32_t fresh_rate;
+} sched;
+
+void pollsched_config(uint8_t filter)
+{
+    sched.period_us = 1000 << (filter & 0x07);
+    sched.next_us = 0;
+}
+
+bool pollsched_due(uint64_t now)
+{
+    return now >= sched.next_us;
+}
+
+void pollsched_done(uint64_t read_us, bool fresh)
+{
+    sched.polls++;
+    if (fresh) {
+        sched.fresh++;
+        sched.next_us = read_us + sched.period_us - sched.period_us / 16;
+    } else {
+        sched.next_us = read_us + sched.period_us / 8;
+    }
+
+    if (read_us - sched.window_us >= 1000000) {
+        sched.poll_rate = sched.polls;
+        sched.fresh_rate = sched.fresh;
+        sched.polls = 0;
+        sched.fresh = 0;
+        sched.window_us = read_us;
+    }
+}
+
+// Sample period from filter config, poll and new data counts per second
+void pollsched_rates(uint32_t *period_us, uint32_t *poll_rate,
+                     uint32_t *fresh_rate)
+{
+    *period_us = sched.period_us;
+    *poll_rate = sched.poll_rate;
+    *fresh_rate = sched.fresh_rate;
+}
+
+/* MPR121 pulls its IRQ low on touch status change until the status is read,
+ * so only chips asserted are read, plus a slow poll of all for safety.
+ * Returns bitmap of chips to read. */
+#define POLL_ALL_US 20000
+
+static uint64_t last_poll_all = 0;
+
+uint8_t pollsched_chips(uint64_t now, bool all, uint8_t asserted)
+{
+    if (all || (now - last_poll_all >= POLL_ALL_US)) {
+        last_poll_all = now;
+        return 0x07;
+    }
+    return asserted & 0x07;
+}
@@ -0,0 +1,20 @@
+/*
+ * Chu Pico Slider Poll Scheduling
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef POLLSCHED_H
+#define POLLSCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+void pollsched_config(uint8_t filter);
+bool pollsched_due(uint64_t now);
+void pollsched_done(uint64_t read_us, bool fresh);
+void pollsched_rates(uint32_t *period_us, uint32_t *poll_rate,
+                     uint32_t *fresh_rate);
+
+uint8_t pollsched_chips(uint64_t now, bool all, uint8_t asserted);
+
+#endif
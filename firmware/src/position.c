@@ -0,0 +1,69 @@
+/*
+ * Chu Pico Slider Position
+ * WHowe <github.com/whowechina>
+ * 
+ * Finger positions by centroid of touched column groups, integer math only.
+ */
+
+#include "position.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define COLUMNS 16
+
+/* delta and touched are for 32 keys, key 2n and 2n + 1 form column n.
+ * Each run of touched columns gives one position, weighted by the column
+ * deltas, and one untouched neighbor on each side is included so a finger
+ * between two columns lands between them. Position 0 is center of column 0,
+ * in 1/POSITION_SCALE of a column. Returns number of positions. */
+int position_compute(const int16_t *delta, uint32_t touched,
+                     uint16_t *pos, int max)
+{
+    int weight[COLUMNS];
+    bool active[COLUMNS];
+    for (int c = 0; c < COLUMNS; c++) {
+        int w = delta[c * 2] + delta[c * 2 + 1];
+        weight[c] = w > 0 ? w : 0;
+        active[c] = touched & (3UL << (c * 2));
+    }
+
+    int count = 0;
+    int c = 0;
+    while ((c < COLUMNS) && (count < max)) {
+        if (!active[c]) {
+            c++;
+            continue;
+        }
+
+        int first = c;
+        while ((c < COLUMNS) && active[c]) {
+            c++;
+        }
+        int last = c - 1;
+        int center = (first + last) * POSITION_SCALE / 2;
+        if ((first > 0) && !active[first - 1]) {
+            first--;
+        }
+        if ((last < COLUMNS - 1) && !active[last + 1]) {
+            last++;
+        }
+
+        int32_t sum = 0;
+        int32_t moment = 0;
+        for (int i = first; i <= last; i++) {
+            sum += weight[i];
+            moment += weight[i] * i;
+        }
+
+        if (sum > 0) {
+            pos[count] = (moment * POSITION_SCALE + sum / 2) / sum;
+        } else {
+            // no usable delta, center of the touched run
+            pos[count] = center;
+        }
+        count++;
+    }
+
+    return count;
+}
@@ -0,0 +1,18 @@
+/*
+ * Chu Pico Slider Position
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define POSITION_MAX 4
+#define POSITION_SCALE 256 // per column
+
+int position_compute(const int16_t *delta, uint32_t touched,
+                     uint16_t *pos, int max);
+
+#endif
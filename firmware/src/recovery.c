@@ -0,0 +1,140 @@
+/*
+ * Chu Pico Slider Recovery
+ * WHowe <github.com/whowechina>
+ * 
+ * Policies keeping the 3 MPR121 chips working, through the mpr121 driver
+ * only, so they run against a bus model on host too.
+ */
+
+#include "recovery.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pico/time.h"
+
+#include "mpr121.h"
+
+/* A chip failing many transfers in a row gets the bus recovered and is
+ * initialized again. Retries back off while any chip stays broken.
+ * Returns bitmap of chips recovered, their config needs to be staged
+ * and committed again. */
+#define RECOVER_STREAK 8
+#define RECOVER_BACKOFF_MIN_US 10000
+#define RECOVER_BACKOFF_MAX_US 1000000
+
+static uint64_t health_next_try = 0;
+static uint32_t health_backoff = RECOVER_BACKOFF_MIN_US;
+
+uint8_t recovery_health(uint32_t baudrate)
+{
+    if (time_us_64() < health_next_try) {
+        return 0;
+    }
+
+    uint8_t faulty = 0;
+    for (int m = 0; m < 3; m++) {
+        if (mpr121_health(MPR121_ADDR + m)->fail_streak >= RECOVER_STREAK) {
+            faulty |= 1 << m;
+        }
+    }
+
+    if (!faulty) {
+        health_backoff = RECOVER_BACKOFF_MIN_US;
+        return 0;
+    }
+
+    mpr121_bus_recover(baudrate);
+    for (int m = 0; m < 3; m++) {
+        if (faulty & (1 << m)) {
+            mpr121_init(MPR121_ADDR + m);
+        }
+    }
+
+    health_next_try = time_us_64() + health_backoff;
+    if (health_backoff < RECOVER_BACKOFF_MAX_US) {
+        health_backoff *= 2;
+    }
+    return faulty;
+}
+
+/* Chips are set up at the slowest speed, then the bus is stepped down
+ * from the given speed until read back of the config is clean enough.
+ * Speeds are slowest first, returns index of the speed in use. */
+#define SELFTEST_ROUNDS 16
+#define SELFTEST_TOLERANCE 1 // failed rounds of all chips
+
+static int bus_selftest()
+{
+    int failed = 0;
+    for (int m = 0; m < 3; m++) {
+        failed += mpr121_selftest(MPR121_ADDR + m, SELFTEST_ROUNDS);
+    }
+    return failed;
+}
+
+int recovery_speed(const uint32_t *speeds, int speed)
+{
+    for (; speed > 0; speed--) {
+        mpr121_set_baudrate(speeds[speed]);
+        if (bus_selftest() <= SELFTEST_TOLERANCE) {
+            break;
+        }
+    }
+    if (speed == 0) {
+        mpr121_set_baudrate(speeds[0]);
+    }
+    return speed;
+}
+
+/* Out of range electrodes (after temperature or humidity swings) get
+ * their chip autoconfigured again. An electrode still out of range after
+ * a rerun can't be fixed that way (damaged pad or wiring), it's left alone
+ * so the other keys on the chip don't keep dropping. Electrodes 8..11 of
+ * the last chip are not connected. Returns bitmap of chips rerun. */
+#define OOR_POLL_US 1000000
+#define OOR_RETRY_US 5000000
+
+static struct {
+    uint64_t next_poll;
+    uint64_t next_retry[3];
+    uint16_t rerun_oor[3]; // electrodes last rerun was for
+    uint16_t given_up[3];
+} range;
+
+uint8_t recovery_range()
+{
+    uint64_t now = time_us_64();
+    if (now < range.next_poll) {
+        return 0;
+    }
+    range.next_poll = now + OOR_POLL_US;
+
+    uint8_t rerun = 0;
+    for (int m = 0; m < 3; m++) {
+        uint16_t used = (m == 2) ? 0x00ff : 0x0fff;
+        uint16_t oor = mpr121_out_of_range(MPR121_ADDR + m) & used;
+
+        uint16_t stuck = oor & range.rerun_oor[m];
+        range.rerun_oor[m] = 0;
+        if (stuck) {
+            range.given_up[m] |= stuck;
+            printf("Slider chip %d electrodes 0x%03x stay out of range, "
+                   "no more autoconfig for them.\n", m, stuck);
+        }
+        range.given_up[m] &= oor; // back in range, may retry later
+
+        uint16_t retry = oor & ~range.given_up[m];
+        if (!retry || (now < range.next_retry[m])) {
+            continue;
+        }
+        range.next_retry[m] = now + OOR_RETRY_US;
+        range.rerun_oor[m] = retry;
+        mpr121_autoconfig(MPR121_ADDR + m);
+        rerun |= 1 << m;
+        printf("Slider chip %d out of range (0x%03x), autoconfig rerun.\n",
+               m, retry);
+    }
+    return rerun;
+}
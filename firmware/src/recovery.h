@@ -0,0 +1,16 @@
+/*
+ * Chu Pico Slider Recovery
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef RECOVERY_H
+#define RECOVERY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+uint8_t recovery_health(uint32_t baudrate);
+int recovery_speed(const uint32_t *speeds, int speed);
+uint8_t recovery_range();
+
+#endif
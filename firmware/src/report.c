@@ -0,0 +1,42 @@
+/*
+ * Chu Pico HID Report Policy
+ * WHowe <github.com/whowechina>
+ * 
+ * Joystick reports go out as soon as anything changes, otherwise only as
+ * a periodic keepalive.
+ */
+
+#include "report.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define KEEPALIVE_US 50000
+
+static uint64_t last_sent = 0;
+static uint32_t sent = 0;
+static uint32_t suppressed = 0;
+
+// Call only when a report can be sent, counts the decision
+bool report_due(bool changed, uint64_t now)
+{
+    if (changed || (now - last_sent >= KEEPALIVE_US)) {
+        last_sent = now;
+        sent++;
+        return true;
+    }
+    suppressed++;
+    return false;
+}
+
+void report_stat(uint32_t *sent_count, uint32_t *suppressed_count)
+{
+    *sent_count = sent;
+    *suppressed_count = suppressed;
+}
+
+void report_reset_stat()
+{
+    sent = 0;
+    suppressed = 0;
+}
@@ -0,0 +1,16 @@
+/*
+ * Chu Pico HID Report Policy
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+bool report_due(bool changed, uint64_t now);
+void report_stat(uint32_t *sent, uint32_t *suppressed);
+void report_reset_stat();
+
+#endif
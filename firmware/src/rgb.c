@@ -19,11 +19,10 @@
 
 #include "board_defs.h"
 #include "config.h"
+#include "ledframe.h"
 
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
 
-static uint32_t rgb_buf[47]; // 16(Keys) + 15(Gaps) + 16(maximum ToF indicators)
-
 #define _MAP_LED(x) _MAKE_MAPPER(x)
 #define _MAKE_MAPPER(x) MAP_LED_##x
 #define MAP_LED_RGB { c1 = r; c2 = g; c3 = b; }
@@ -83,6 +82,37 @@ uint32_t rgb32_from_hsv(uint8_t h, uint8_t s, uint8_t v)
     }
 }
 
+bool rgb_begin(int writer)
+{
+    return ledframe_begin(writer);
+}
+
+void rgb_end()
+{
+    ledframe_end();
+}
+
+void rgb_present(bool complete)
+{
+    ledframe_present(complete);
+}
+
+bool rgb_pending()
+{
+    return ledframe_pending();
+}
+
+void rgb_frame_seq(uint8_t seq)
+{
+    ledframe_seq(seq);
+}
+
+void rgb_frame_stat(uint32_t *presented, uint32_t *dropped, uint32_t *torn,
+                    uint32_t *skipped)
+{
+    ledframe_stat(presented, dropped, torn, skipped);
+}
+
 static void drive_led()
 {
     static uint64_t last = 0;
@@ -92,23 +122,24 @@ static void drive_led()
     }
     last = now;
 
+    const uint32_t *frame = ledframe_front();
     for (int i = 30; i >= 0; i--) {
-        pio_sm_put_blocking(pio0, 0, rgb_buf[i] << 8u);
+        pio_sm_put_blocking(pio0, 0, frame[i] << 8u);
     }
-    for (int i = 31; i < ARRAY_SIZE(rgb_buf); i++) {
-        pio_sm_put_blocking(pio0, 0, rgb_buf[i] << 8u);
+    for (int i = 31; i < LED_NUM; i++) {
+        pio_sm_put_blocking(pio0, 0, frame[i] << 8u);
     }
 }
 
 void rgb_set_colors(const uint32_t *colors, unsigned index, size_t num)
 {
-    if (index >= ARRAY_SIZE(rgb_buf)) {
+    if (index >= LED_NUM) {
         return;
     }
-    if (index + num > ARRAY_SIZE(rgb_buf)) {
-        num = ARRAY_SIZE(rgb_buf) - index;
+    if (index + num > LED_NUM) {
+        num = LED_NUM - index;
     }
-    memcpy(&rgb_buf[index], colors, num * sizeof(*colors));
+    memcpy(ledframe_back() + index, colors, num * sizeof(*colors));
 }
 
 static inline uint32_t apply_level(uint32_t color)
@@ -126,10 +157,10 @@ static inline uint32_t apply_level(uint32_t color)
 
 void rgb_set_color(unsigned index, uint32_t color)
 {
-    if (index >= ARRAY_SIZE(rgb_buf)) {
+    if (index >= LED_NUM) {
         return;
     }
-    rgb_buf[index] = apply_level(color);
+    ledframe_back()[index] = apply_level(color);
 }
 
 void rgb_key_color(unsigned index, uint32_t color)
@@ -137,7 +168,7 @@ void rgb_key_color(unsigned index, uint32_t color)
     if (index > 16) {
         return;
     }
-    rgb_buf[index * 2] = apply_level(color);
+    ledframe_back()[index * 2] = apply_level(color);
 }
 
 void rgb_gap_color(unsigned index, uint32_t color)
@@ -145,27 +176,29 @@ void rgb_gap_color(unsigned index, uint32_t color)
     if (index > 15) {
         return;
     }
-    rgb_buf[index * 2 + 1] = apply_level(color);
+    ledframe_back()[index * 2 + 1] = apply_level(color);
 }
 
 void rgb_set_brg(unsigned index, const uint8_t *brg_array, size_t num)
 {
-    if (index >= ARRAY_SIZE(rgb_buf)) {
+    if (index >= LED_NUM) {
         return;
     }
-    if (index + num > ARRAY_SIZE(rgb_buf)) {
-        num = ARRAY_SIZE(rgb_buf) - index;
+    if (index + num > LED_NUM) {
+        num = LED_NUM - index;
     }
     for (int i = 0; i < num; i++) {
         uint8_t b = brg_array[i * 3 + 0];
         uint8_t r = brg_array[i * 3 + 1];
         uint8_t g = brg_array[i * 3 + 2];
-        rgb_buf[index + i] = apply_level(rgb32(r, g, b, false));
+        ledframe_back()[index + i] = apply_level(rgb32(r, g, b, false));
     }
 }
 
 void rgb_init()
 {
+    ledframe_init();
+
     uint pio0_offset = pio_add_program(pio0, &ws2812_program);
 
     gpio_set_drive_strength(RGB_PIN, GPIO_DRIVE_STRENGTH_2MA);
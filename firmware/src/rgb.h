@@ -11,6 +11,7 @@
 #include <stdbool.h>
 
 #include "config.h"
+#include "ledframe.h"
 
 void rgb_init();
 void rgb_update();
@@ -26,4 +27,14 @@ void rgb_gap_color(unsigned index, uint32_t color);
 /* num of the rgb leds, num*3 bytes in the array */
 void rgb_set_brg(unsigned index, const uint8_t *brg_array, size_t num);
 
+/* Colors set above go to the back frame, only between begin and end of a
+ * writer (LEDFRAME_HOST or LEDFRAME_IDLE). They show after it's presented. */
+bool rgb_begin(int writer);
+void rgb_end();
+void rgb_present(bool complete);
+bool rgb_pending();
+void rgb_frame_seq(uint8_t seq);
+void rgb_frame_stat(uint32_t *presented, uint32_t *dropped, uint32_t *torn,
+                    uint32_t *skipped);
+
 #endif
@@ -7,6 +7,7 @@
 
 #include "slider.h"
 
+#include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -14,21 +15,113 @@
 #include "bsp/board.h"
 #include "hardware/gpio.h"
 #include "hardware/i2c.h"
+#include "hardware/sync.h"
 
 #include "board_defs.h"
 
 #include "config.h"
 #include "mpr121.h"
-
-#define MPR121_ADDR 0x5A
+#include "detect.h"
+#include "position.h"
+#include "event.h"
+#include "input.h"
+#include "pollsched.h"
+#include "recovery.h"
 
 static uint16_t readout[36];
+static uint16_t baselines[36];
 static uint16_t touch[3];
 static unsigned touch_count[36];
+static uint32_t offline_us = 0;
+
+/* Touch status only, or everything up to the baselines for firmware side
+ * detection: touch status, out of range, filtered data and baselines. */
+#define READ_LEN_STATUS 2
+#define READ_LEN_DETECT 0x2A
+
+static uint8_t regs_async[3 * READ_LEN_DETECT];
+static uint8_t reading_chips[3];
+static int reading_num = 0;
+static int reading_len = READ_LEN_STATUS;
+static uint64_t reading_us; // when the read was queued
+
+static int filter_override = -1;
+
+static uint8_t active_filter()
+{
+    return filter_override >= 0 ? filter_override : chu_cfg->sense.filter;
+}
+
+#ifdef MPR121_IRQ_PINS
+
+static const uint8_t irq_pins[3] = MPR121_IRQ_PINS;
+static volatile uint8_t irq_pending = 0;
+
+static void irq_callback(uint gpio, uint32_t events)
+{
+    for (int m = 0; m < 3; m++) {
+        if (gpio == irq_pins[m]) {
+            irq_pending |= 1 << m;
+        }
+    }
+}
+
+static void irq_init()
+{
+    for (int m = 0; m < 3; m++) {
+        gpio_init(irq_pins[m]);
+        gpio_set_dir(irq_pins[m], GPIO_IN);
+        gpio_pull_up(irq_pins[m]);
+        gpio_set_irq_enabled_with_callback(irq_pins[m], GPIO_IRQ_EDGE_FALL,
+                                           true, irq_callback);
+    }
+}
+
+// Chips asserting their IRQ, level is still low if an edge was missed
+static uint8_t chips_to_read()
+{
+    uint32_t ints = save_and_disable_interrupts();
+    uint8_t chips = irq_pending;
+    irq_pending = 0;
+    restore_interrupts(ints);
+
+    for (int m = 0; m < 3; m++) {
+        if (!gpio_get(irq_pins[m])) {
+            chips |= 1 << m;
+        }
+    }
+    return pollsched_chips(time_us_64(), chu_cfg->detect.enabled, chips);
+}
+#else
+
+static void irq_init()
+{
+}
+
+static uint8_t chips_to_read()
+{
+    return 0x07;
+}
+#endif
+
+static const uint32_t i2c_speeds[] = I2C_SPEEDS;
+static int i2c_speed = 0;
+
+// Returns index of the speed in use
+int slider_i2c_speed_apply()
+{
+    i2c_speed = recovery_speed(i2c_speeds, chu_cfg->i2c.speed - 1);
+    return i2c_speed;
+}
+
+uint32_t slider_i2c_speed()
+{
+    return i2c_speeds[i2c_speed];
+}
 
 void slider_init()
 {
-    i2c_init(I2C_PORT, I2C_FREQ);
+    i2c_init(I2C_PORT, i2c_speeds[0]);
     gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
     gpio_set_function(I2C_SCL, GPIO_FUNC_I2C);
     gpio_pull_up(I2C_SDA);
@@ -38,25 +131,147 @@ void slider_init()
         mpr121_init(MPR121_ADDR + m);
     }
     slider_update_config();
+    slider_i2c_speed_apply();
+    detect_init();
+    mpr121_async_init();
+    irq_init();
+}
+
+// regs are from register 0x00, returns touch bits like the touch status
+static uint16_t detect_chip(int m, const uint8_t *regs)
+{
+    uint32_t now = time_us_32();
+    uint16_t bits = 0;
+    for (int i = 0; (i < 12) && (m * 12 + i < 32); i++) {
+        uint16_t filtered = regs[0x04 + i * 2] | (regs[0x05 + i * 2] << 8);
+        uint16_t baseline = regs[0x1E + i] << 2;
+        detect_key(m * 12 + i, filtered & 0x3ff, baseline, now);
+        if (detect_touched(m * 12 + i)) {
+            bits |= 1 << i;
+        }
+    }
+    return bits;
 }
 
+// Keys of recovered chips are released, they get their config again
+static void check_health()
+{
+    uint8_t recovered = recovery_health(i2c_speeds[i2c_speed]);
+    if (!recovered) {
+        return;
+    }
+    for (int m = 0; m < 3; m++) {
+        if (recovered & (1 << m)) {
+            touch[m] = 0;
+        }
+    }
+    slider_update_config();
+}
+
+/* An autoconfig rerun reloads the baseline of every electrode on the
+ * chip, so all its keys are masked while it settles. */
+#define OOR_MASK_US 200000
+
+static uint64_t masked_until[3];
+
+static void check_range()
+{
+    uint8_t rerun = recovery_range();
+    for (int m = 0; m < 3; m++) {
+        if (rerun & (1 << m)) {
+            masked_until[m] = time_us_64() + OOR_MASK_US;
+        }
+    }
+}
+
+/* Touch status is read asynchronously, a new read is queued as soon as the
+ * previous one completes. */
 void slider_update()
 {
     static uint16_t last_touched[3];
 
-    touch[0] = mpr121_touched(MPR121_ADDR);
-    touch[1] = mpr121_touched(MPR121_ADDR + 1);
-    touch[2] = mpr121_touched(MPR121_ADDR + 2);
+    if (mpr121_async_busy()) {
+        return;
+    }
 
+    static uint32_t data_hash[3];
+    bool fresh = false;
+    uint8_t failed = mpr121_async_failed();
+    for (int i = 0; i < reading_num; i++) {
+        if (failed & (1 << i)) {
+            continue;
+        }
+        const uint8_t *regs = regs_async + i * reading_len;
+        int m = reading_chips[i];
+        if (reading_len == READ_LEN_DETECT) {
+            uint32_t hash = 0;
+            for (int r = 0x04; r < READ_LEN_DETECT; r++) {
+                hash = hash * 31 + regs[r];
+            }
+            fresh |= (hash != data_hash[m]);
+            data_hash[m] = hash;
+            touch[m] = detect_chip(m, regs);
+        } else {
+            uint16_t status = regs[0] | (regs[1] << 8);
+            fresh |= (status != touch[m]);
+            touch[m] = status;
+        }
+    }
+
+    uint64_t now64 = time_us_64();
+    if (reading_num > 0) {
+        pollsched_done(reading_us, fresh);
+    }
+    reading_num = 0;
+
+    check_health();
+    check_range();
     for (int m = 0; m < 3; m++) {
-        uint16_t just_touched = touch[m] & ~last_touched[m];
+        if (now64 < masked_until[m]) {
+            touch[m] = 0;
+        }
+    }
+
+    /* Touch status alone seldom changes and can't show when a sample
+     * happened, so status only reads are not scheduled, they run back to
+     * back and only get counted. */
+    bool scheduled = chu_cfg->detect.enabled;
+    uint8_t chips = (!scheduled || pollsched_due(now64)) ? chips_to_read() : 0;
+    uint8_t addrs[3];
+    int num = 0;
+    for (int m = 0; m < 3; m++) {
+        if (chips & (1 << m)) {
+            reading_chips[num] = m;
+            addrs[num] = MPR121_ADDR + m;
+            num++;
+        }
+    }
+
+    int len = chu_cfg->detect.enabled ? READ_LEN_DETECT : READ_LEN_STATUS;
+    if ((num > 0) && mpr121_read_async(addrs, num, 0x00, regs_async, len)) {
+        reading_num = num;
+        reading_len = len;
+        reading_us = now64;
+    }
+
+    uint32_t now = time_us_32();
+    uint32_t touch_bits = 0;
+    for (int m = 0; m < 3; m++) {
+        touch_bits |= (uint32_t)touch[m] << (m * 12);
+        uint16_t changed = touch[m] ^ last_touched[m];
         last_touched[m] = touch[m];
-        for (int i = 0; i < 12; i++) {
-            if (just_touched & (1 << i)) {
+        for (int i = 0; (i < 12) && (m * 12 + i < 32); i++) {
+            if (!(changed & (1 << i))) {
+                continue;
+            }
+            bool pressed = touch[m] & (1 << i);
+            if (pressed) {
                 touch_count[m * 12 + i]++;
             }
+            event_push(EVENT_RING_SLIDER, m * 12 + i, pressed, now);
         }
     }
+    input_publish_touch(touch_bits, now);
 }
 
 const uint16_t *slider_raw()
@@ -67,6 +282,31 @@ const uint16_t *slider_raw()
     return readout;
 }
 
+const uint16_t *slider_baseline()
+{
+    mpr121_baseline(MPR121_ADDR, baselines, 12);
+    mpr121_baseline(MPR121_ADDR + 1, baselines + 12, 12);
+    mpr121_baseline(MPR121_ADDR + 2, baselines + 24, 12);
+    return baselines;
+}
+
+/* Deltas come from the detection engine, without it every touched column
+ * weighs the same and positions are at half column resolution. */
+int slider_positions(uint16_t *pos, int max)
+{
+    int16_t delta[32] = {0};
+    uint32_t touched = 0;
+    for (int i = 0; i < 32; i++) {
+        if (chu_cfg->detect.enabled) {
+            delta[i] = detect_delta(i);
+        }
+        if (slider_touched(i)) {
+            touched |= 1UL << i;
+        }
+    }
+    return position_compute(delta, touched, pos, max);
+}
+
 bool slider_touched(unsigned key)
 {
     if (key >= 32) {
@@ -88,16 +328,41 @@ void slider_reset_stat()
     memset(touch_count, 0, sizeof(touch_count));
 }
 
+/* All pending changes of a chip go in one stop/resume window, chips are
+ * done one by one so the rest of the slider keeps working. */
+/* Filter used instead of the configured one until cleared with -1, so
+ * trying settings never touches the config that gets saved. */
+void slider_filter_override(int filter)
+{
+    filter_override = filter;
+    slider_update_config();
+}
+
 void slider_update_config()
 {
+    uint8_t filter = active_filter();
+    offline_us = 0;
     for (int m = 0; m < 3; m++) {
         mpr121_debounce(MPR121_ADDR + m, chu_cfg->sense.debounce_touch,
                                          chu_cfg->sense.debounce_release);
         mpr121_sense(MPR121_ADDR + m, chu_cfg->sense.global,
                                       chu_cfg->sense.keys + m * 12,
                                       m != 2 ? 12 : 8);
-        mpr121_filter(MPR121_ADDR + m, chu_cfg->sense.filter >> 6,
-                                       (chu_cfg->sense.filter >> 4) & 0x03,
-                                       chu_cfg->sense.filter & 0x07);
+        mpr121_filter(MPR121_ADDR + m, filter >> 6, (filter >> 4) & 0x03,
+                                       filter & 0x07);
+        offline_us += mpr121_commit(MPR121_ADDR + m);
     }
+    pollsched_config(filter);
+}
+
+// Sample period from filter config, poll and new data counts per second
+void slider_rates(uint32_t *period_us, uint32_t *poll_rate, uint32_t *fresh_rate)
+{
+    pollsched_rates(period_us, poll_rate, fresh_rate);
+}
+
+// Total time chips were stopped by the last config update
+uint32_t slider_offline_us()
+{
+    return offline_us;
 }
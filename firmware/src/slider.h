@@ -12,8 +12,15 @@
 void slider_init();
 void slider_update();
 bool slider_touched(unsigned key);
+int slider_positions(uint16_t *pos, int max);
 const uint16_t *slider_raw();
+const uint16_t *slider_baseline();
 void slider_update_config();
+void slider_filter_override(int filter);
+uint32_t slider_offline_us();
+int slider_i2c_speed_apply();
+uint32_t slider_i2c_speed();
+void slider_rates(uint32_t *period_us, uint32_t *poll_rate, uint32_t *fresh_rate);
 unsigned slider_count(unsigned key);
 void slider_reset_stat();
 
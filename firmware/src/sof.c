@@ -0,0 +1,124 @@
+/*
+ * Chu Pico USB Frame Sync
+ * WHowe <github.com/whowechina>
+ * 
+ * Schedules report submission a fixed offset before the next USB start of
+ * frame, so the host picks up every report with the same delay. Only the
+ * submission is synchronized, slider polls follow the MPR121 sample
+ * interval and air frames follow the scan. How old their data is at the
+ * start of frame is what the age stat shows. Scheduling takes times as
+ * parameters, the start of frame time itself is taken in the USB interrupt.
+ */
+
+#include "sof.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "pico/time.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/structs/usb.h"
+
+#include "tusb.h"
+
+#include "config.h"
+
+#define FRAME_US 1000
+#define LOST_US (FRAME_US * 3) // no SOF for this long, run freely
+
+static struct {
+    uint32_t offset_us;
+    uint64_t last_sof;
+    uint32_t input_us; // publish time of the oldest input in the report
+    bool submitted; // in current frame
+} sync;
+
+static sof_stat_t stat;
+static volatile uint64_t sof_stamp;
+
+/* TinyUSB queues SOF and calls tud_sof_cb() from tud_task(), up to a whole
+ * main loop late, so the time is taken here. It has to run before TinyUSB's
+ * handler clears the SOF status: same order priority but added later. */
+static void sof_irq()
+{
+    if (usb_hw->ints & USB_INTS_DEV_SOF_BITS) {
+        sof_stamp = time_us_64();
+    }
+}
+
+// After tusb_init()
+void sof_init()
+{
+    irq_add_shared_handler(USBCTRL_IRQ, sof_irq,
+                           PICO_SHARED_IRQ_HANDLER_HIGHEST_ORDER_PRIORITY);
+}
+
+// Time of the latest start of frame
+uint64_t sof_time()
+{
+    uint32_t save = save_and_disable_interrupts();
+    uint64_t stamp = sof_stamp;
+    restore_interrupts(save);
+    return stamp;
+}
+
+void sof_update_config()
+{
+    sync.offset_us = chu_cfg->sof.offset_us;
+    tud_sof_cb_enable(chu_cfg->sof.enabled);
+}
+
+void sof_frame(uint64_t now)
+{
+    if (now == sync.last_sof) {
+        return; // queued callbacks catching up on the same frame
+    }
+
+    if (sync.submitted) {
+        uint32_t age = (uint32_t)now - sync.input_us;
+        if ((stat.age_min_us == 0) || (age < stat.age_min_us)) {
+            stat.age_min_us = age;
+        }
+        if (age > stat.age_max_us) {
+            stat.age_max_us = age;
+        }
+        stat.age_avg_us += ((int32_t)age - (int32_t)stat.age_avg_us) / 16;
+    } else if (sync.last_sof) {
+        stat.missed++;
+    }
+
+    stat.frames++;
+    sync.last_sof = now;
+    sync.submitted = false;
+}
+
+// True once per frame, offset before next start of frame
+bool sof_due(uint64_t now)
+{
+    if (now - sync.last_sof > LOST_US) {
+        return true;
+    }
+    if (sync.submitted) {
+        return false;
+    }
+    return now >= sync.last_sof + FRAME_US - sync.offset_us;
+}
+
+// Publish times of the touch and air input the report was made of
+void sof_submitted(uint32_t touch_us, uint32_t air_us)
+{
+    sync.input_us = ((int32_t)(touch_us - air_us) < 0) ? touch_us : air_us;
+    sync.submitted = true;
+}
+
+const sof_stat_t *sof_stat()
+{
+    return &stat;
+}
+
+void sof_reset_stat()
+{
+    memset(&stat, 0, sizeof(stat));
+}
@@ -0,0 +1,29 @@
+/*
+ * Chu Pico USB Frame Sync
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef SOF_H
+#define SOF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint32_t frames;
+    uint32_t missed; // frames without a report submitted
+    uint32_t age_min_us; // input publish to next start of frame
+    uint32_t age_avg_us;
+    uint32_t age_max_us;
+} sof_stat_t;
+
+void sof_init();
+uint64_t sof_time();
+void sof_update_config();
+void sof_frame(uint64_t now);
+bool sof_due(uint64_t now);
+void sof_submitted(uint32_t touch_us, uint32_t air_us);
+const sof_stat_t *sof_stat();
+void sof_reset_stat();
+
+#endif
@@ -84,6 +84,7 @@ uint8_t const desc_hid_report_led[] = {
     CHUPICO_REPORT_DESC_LED_SLIDER_15,
     CHUPICO_REPORT_DESC_LED_TOWER_6,
     CHUPICO_REPORT_DESC_LED_COMPRESSED,
+    CHUPICO_REPORT_DESC_LED_FRAME,
     CHUPICO_LED_FOOTER
 };
 
@@ -121,6 +122,9 @@ enum { ITF_NUM_JOY, ITF_NUM_LED, ITF_NUM_NKRO,
 #define EPNUM_LED 0x82
 #define EPNUM_KEY 0x83
 
+// Full speed interrupt endpoints max out at 64, HID buffers can be larger
+#define HID_EP_SIZE 64
+
 #define EPNUM_CLI_NOTIF 0x85
 #define EPNUM_CLI_OUT   0x06
 #define EPNUM_CLI_IN    0x86
@@ -135,15 +139,15 @@ uint8_t const desc_configuration_joy[] = {
     // address, size & polling interval
     TUD_HID_DESCRIPTOR(ITF_NUM_JOY, 4, HID_ITF_PROTOCOL_NONE,
                        sizeof(desc_hid_report_joy), EPNUM_JOY,
-                       CFG_TUD_HID_EP_BUFSIZE, 1),
+                       HID_EP_SIZE, 1),
 
     TUD_HID_DESCRIPTOR(ITF_NUM_LED, 5, HID_ITF_PROTOCOL_NONE,
                        sizeof(desc_hid_report_led), EPNUM_LED,
-                       CFG_TUD_HID_EP_BUFSIZE, 4),
+                       HID_EP_SIZE, 4),
 
     TUD_HID_DESCRIPTOR(ITF_NUM_NKRO, 6, HID_ITF_PROTOCOL_NONE,
                        sizeof(desc_hid_report_nkro), EPNUM_KEY,
-                       CFG_TUD_HID_EP_BUFSIZE, 1),
+                       HID_EP_SIZE, 1),
 
     TUD_CDC_DESCRIPTOR(ITF_NUM_CLI, 7, EPNUM_CLI_NOTIF,
                        8, EPNUM_CLI_OUT, EPNUM_CLI_IN, 64),
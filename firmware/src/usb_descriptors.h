@@ -10,6 +10,7 @@ enum {
     REPORT_ID_LED_SLIDER_15 = 5,
     REPORT_ID_LED_TOWER_6 = 6,
     REPORT_ID_LED_COMPRESSED = 11,
+    REPORT_ID_LED_FRAME = 12,
 };
 
 // because they are missing from tusb_hid.h
@@ -47,8 +48,8 @@ enum {
         HID_REPORT_SIZE(8), HID_REPORT_COUNT(4),                               \
         HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),                     \
                                                                                \
-        HID_USAGE_PAGE_N(HID_USAGE_PAGE_VENDOR, 2),                            \
-        HID_USAGE(0),                                                          \
+        HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),                                \
+        HID_USAGE(HID_USAGE_DESKTOP_RY), /* Air hand height */                 \
         HID_LOGICAL_MIN(0x00), HID_LOGICAL_MAX(0xff),                          \
         HID_REPORT_SIZE(8), HID_REPORT_COUNT(1),                               \
         HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),                     \
@@ -102,6 +103,16 @@ enum {
         HID_REPORT_SIZE(8), HID_REPORT_COUNT(63),                              \
         HID_FEATURE(HID_DATA | HID_VARIABLE | HID_ABSOLUTE)
 
+// Whole LED frame in one report: frame sequence number, then slider 31 LEDs
+// and tower 6 LEDs (111 rgb zones, BRG order)
+#define CHUPICO_REPORT_DESC_LED_FRAME                                          \
+        HID_REPORT_ID(REPORT_ID_LED_FRAME)                                     \
+        HID_REPORT_COUNT(112), HID_REPORT_SIZE(8),                             \
+        HID_LOGICAL_MIN(0x00), HID_LOGICAL_MAX_N(0x00ff, 2),                   \
+        HID_USAGE_PAGE(HID_USAGE_PAGE_ORDINAL),                                \
+        HID_USAGE_MIN(1), HID_USAGE_MAX(112),                                  \
+        HID_OUTPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE)
+
 #define CHUPICO_REPORT_DESC_NKRO                                               \
     HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),                                    \
     HID_USAGE(HID_USAGE_DESKTOP_KEYBOARD),                                     \
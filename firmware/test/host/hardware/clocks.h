@@ -0,0 +1,20 @@
+/*
+ * Chu Pico Host Tests, hardware/clocks.h stand-in
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef HOST_HARDWARE_CLOCKS_H
+#define HOST_HARDWARE_CLOCKS_H
+
+#include <stdint.h>
+
+enum clock_index {
+    clk_sys = 5,
+};
+
+static inline uint32_t clock_get_hz(enum clock_index clk)
+{
+    return 125000000;
+}
+
+#endif
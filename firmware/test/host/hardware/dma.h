@@ -0,0 +1,70 @@
+/*
+ * Chu Pico Host Tests, hardware/dma.h stand-in
+ * WHowe <github.com/whowechina>
+ * 
+ * Channels only move data for the I2C model, paced by its DREQs.
+ */
+
+#ifndef HOST_HARDWARE_DMA_H
+#define HOST_HARDWARE_DMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pico.h"
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2,
+};
+
+typedef struct {
+    enum dma_channel_transfer_size size;
+    bool read_increment;
+    bool write_increment;
+    uint dreq;
+} dma_channel_config;
+
+int dma_claim_unused_channel(bool required);
+dma_channel_config dma_channel_get_default_config(uint channel);
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c,
+                                        enum dma_channel_transfer_size size)
+{
+    c->size = size;
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config *c,
+                                                     bool incr)
+{
+    c->read_increment = incr;
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config *c,
+                                                      bool incr)
+{
+    c->write_increment = incr;
+}
+
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq)
+{
+    c->dreq = dreq;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config,
+                           volatile void *write_addr,
+                           const volatile void *read_addr,
+                           uint transfer_count, bool trigger);
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr,
+                                bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr,
+                               bool trigger);
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count,
+                                 bool trigger);
+void dma_channel_abort(uint channel);
+void dma_channel_set_irq1_enabled(uint channel, bool enabled);
+bool dma_channel_get_irq1_status(uint channel);
+void dma_channel_acknowledge_irq1(uint channel);
+
+#endif
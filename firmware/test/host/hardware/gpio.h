@@ -0,0 +1,29 @@
+/*
+ * Chu Pico Host Tests, hardware/gpio.h stand-in
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef HOST_HARDWARE_GPIO_H
+#define HOST_HARDWARE_GPIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pico.h"
+
+#define GPIO_IN 0
+#define GPIO_OUT 1
+
+enum gpio_function {
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_SIO = 5,
+};
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_pull_up(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * Chu Pico Host Tests, hardware/i2c.h stand-in
+ * WHowe <github.com/whowechina>
+ * 
+ * Only i2c0 exists, it's wired to the bus model in i2c.c.
+ */
+
+#ifndef HOST_HARDWARE_I2C_H
+#define HOST_HARDWARE_I2C_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "pico.h"
+#include "pico/time.h"
+
+#define I2C_IC_DATA_CMD_RESTART_BITS 0x00000400
+#define I2C_IC_DATA_CMD_STOP_BITS 0x00000200
+#define I2C_IC_DATA_CMD_CMD_BITS 0x00000100
+#define I2C_IC_DMA_CR_TDMAE_BITS 0x00000002
+#define I2C_IC_DMA_CR_RDMAE_BITS 0x00000001
+
+typedef struct {
+    volatile uint32_t tar;
+    volatile uint32_t data_cmd;
+    volatile uint32_t clr_tx_abrt;
+    volatile uint32_t enable;
+    volatile uint32_t tx_abrt_source;
+    volatile uint32_t dma_cr;
+    volatile uint32_t dma_tdlr;
+    volatile uint32_t dma_rdlr;
+} i2c_hw_t;
+
+typedef struct {
+    i2c_hw_t *hw;
+} i2c_inst_t;
+
+extern i2c_inst_t host_i2c0;
+#define i2c0 (&host_i2c0)
+
+static inline i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c)
+{
+    return i2c->hw;
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+void i2c_deinit(i2c_inst_t *i2c);
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate);
+uint i2c_get_dreq(i2c_inst_t *i2c, bool is_tx);
+
+int i2c_write_blocking_until(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src,
+                             size_t len, bool nostop, absolute_time_t until);
+int i2c_read_blocking_until(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst,
+                            size_t len, bool nostop, absolute_time_t until);
+
+#endif
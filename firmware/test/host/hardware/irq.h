@@ -0,0 +1,23 @@
+/*
+ * Chu Pico Host Tests, hardware/irq.h stand-in
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef HOST_HARDWARE_IRQ_H
+#define HOST_HARDWARE_IRQ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define USBCTRL_IRQ 5
+#define DMA_IRQ_1 12
+#define PICO_SHARED_IRQ_HANDLER_HIGHEST_ORDER_PRIORITY 0xff
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+typedef void (*irq_handler_t)();
+
+void irq_add_shared_handler(unsigned num, irq_handler_t handler,
+                            uint8_t order_priority);
+void irq_set_enabled(unsigned num, bool enabled);
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * Chu Pico Host Tests, hardware/pio.h stand-in
+ * WHowe <github.com/whowechina>
+ * 
+ * Configuration calls land in a model of one state machine, see pio.c.
+ */
+
+#ifndef HOST_HARDWARE_PIO_H
+#define HOST_HARDWARE_PIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pico.h"
+
+typedef struct {
+    int num;
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t host_pio_hw[2];
+#define pio0 (&host_pio_hw[0])
+#define pio1 (&host_pio_hw[1])
+
+enum pio_fifo_join {
+    PIO_FIFO_JOIN_NONE = 0,
+    PIO_FIFO_JOIN_TX = 1,
+    PIO_FIFO_JOIN_RX = 2,
+};
+
+typedef struct {
+    uint offset;
+    uint set_base;
+    uint set_count;
+    uint sideset_base;
+    uint in_base;
+    bool in_shift_right;
+    bool autopush;
+    uint push_threshold;
+    enum pio_fifo_join join;
+    float clkdiv;
+} pio_sm_config;
+
+pio_sm_config host_pio_default_config(uint offset);
+
+void pio_gpio_init(PIO pio, uint pin);
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base,
+                                    uint pin_count, bool is_out);
+
+void sm_config_set_set_pins(pio_sm_config *c, uint set_base, uint set_count);
+void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base);
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base);
+void sm_config_set_in_shift(pio_sm_config *c, bool shift_right,
+                            bool autopush, uint push_threshold);
+void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join);
+void sm_config_set_clkdiv(pio_sm_config *c, float div);
+
+void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *c);
+void pio_sm_put(PIO pio, uint sm, uint32_t data);
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled);
+
+#endif
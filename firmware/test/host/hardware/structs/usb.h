@@ -0,0 +1,20 @@
+/*
+ * Chu Pico Host Tests, hardware/structs/usb.h stand-in
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef HOST_HARDWARE_STRUCTS_USB_H
+#define HOST_HARDWARE_STRUCTS_USB_H
+
+#include <stdint.h>
+
+#define USB_INTS_DEV_SOF_BITS 0x00020000
+
+typedef struct {
+    volatile uint32_t ints;
+} usb_hw_t;
+
+extern usb_hw_t host_usb_hw;
+#define usb_hw (&host_usb_hw)
+
+#endif
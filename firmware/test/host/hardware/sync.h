@@ -0,0 +1,51 @@
+/*
+ * Chu Pico Host Tests, hardware/sync.h stand-in
+ * WHowe <github.com/whowechina>
+ * 
+ * Spinlocks and barriers on C11 atomics, so threads can play the cores.
+ * Barriers also yield now and then, so even on a single CPU host another
+ * thread gets to run right in the middle of a write.
+ */
+
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <sched.h>
+
+#include "pico.h"
+
+typedef atomic_flag spin_lock_t;
+
+int spin_lock_claim_unused(bool required);
+spin_lock_t *spin_lock_init(int lock_num);
+
+static inline uint32_t spin_lock_blocking(spin_lock_t *lock)
+{
+    while (atomic_flag_test_and_set_explicit(lock, memory_order_acquire)) {
+        sched_yield();
+    }
+    return 0;
+}
+
+static inline void spin_unlock(spin_lock_t *lock, uint32_t save)
+{
+    atomic_flag_clear_explicit(lock, memory_order_release);
+}
+
+static inline uint32_t save_and_disable_interrupts()
+{
+    return 0;
+}
+
+static inline void restore_interrupts(uint32_t save)
+{
+}
+
+void host_barrier();
+
+#define __dmb() host_barrier()
+
+#endif
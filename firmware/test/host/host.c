@@ -0,0 +1,142 @@
+/*
+ * Chu Pico Host Tests, stand-ins for the SDK
+ * WHowe <github.com/whowechina>
+ */
+
+#include "host.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sched.h>
+
+#include "pico/time.h"
+#include "hardware/sync.h"
+#include "hardware/irq.h"
+
+#include "config.h"
+
+static chu_cfg_t cfg;
+chu_cfg_t *chu_cfg = &cfg;
+
+void config_changed()
+{
+}
+
+static uint64_t now_us = 0;
+
+void host_set_time(uint64_t us)
+{
+    now_us = us;
+}
+
+uint64_t time_us_64()
+{
+    return now_us;
+}
+
+uint32_t time_us_32()
+{
+    return now_us;
+}
+
+void busy_wait_us(uint64_t delay_us)
+{
+    now_us += delay_us;
+}
+
+static void (*spin_hook)() = NULL;
+
+void host_on_spin(void (*hook)())
+{
+    spin_hook = hook;
+}
+
+void host_spin()
+{
+    if (spin_hook) {
+        spin_hook();
+    } else {
+        sched_yield();
+    }
+}
+
+#define MAX_HANDLERS 4
+
+static struct {
+    unsigned num;
+    irq_handler_t handler;
+} handlers[MAX_HANDLERS];
+static int handler_num = 0;
+static uint32_t irq_masked = 0;
+static uint32_t irq_pending = 0;
+
+void irq_add_shared_handler(unsigned num, irq_handler_t handler,
+                            uint8_t order_priority)
+{
+    if (handler_num < MAX_HANDLERS) {
+        handlers[handler_num].num = num;
+        handlers[handler_num].handler = handler;
+        handler_num++;
+    }
+}
+
+// A masked irq stays pending until enabled again, like the NVIC
+void irq_set_enabled(unsigned num, bool enabled)
+{
+    if (enabled) {
+        irq_masked &= ~(1 << num);
+        if (irq_pending & (1 << num)) {
+            host_irq(num);
+        }
+    } else {
+        irq_masked |= 1 << num;
+    }
+}
+
+void host_irq(unsigned num)
+{
+    if (irq_masked & (1 << num)) {
+        irq_pending |= 1 << num;
+        return;
+    }
+    irq_pending &= ~(1 << num);
+    for (int i = 0; i < handler_num; i++) {
+        if (handlers[i].num == num) {
+            handlers[i].handler();
+        }
+    }
+}
+
+static spin_lock_t locks[32];
+static int lock_num = 0;
+
+int spin_lock_claim_unused(bool required)
+{
+    return lock_num++;
+}
+
+spin_lock_t *spin_lock_init(int num)
+{
+    atomic_flag_clear(&locks[num]);
+    return &locks[num];
+}
+
+static void (*barrier_hook)() = NULL;
+
+void host_on_barrier(void (*hook)())
+{
+    barrier_hook = hook;
+}
+
+void host_barrier()
+{
+    static _Thread_local uint32_t count = 0;
+    atomic_thread_fence(memory_order_seq_cst);
+    if (barrier_hook) {
+        barrier_hook();
+    }
+    if (++count % 7 == 0) {
+        sched_yield();
+    }
+}
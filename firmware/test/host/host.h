@@ -0,0 +1,68 @@
+/*
+ * Chu Pico Host Tests, stand-ins for the SDK
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Time only moves when a test says so
+void host_set_time(uint64_t us);
+
+// Called on every tight_loop_contents() instead of yielding, so busy waits
+// let hardware models run
+void host_on_spin(void (*hook)());
+
+// Called on every __dmb(), lets a test step in at exact points
+void host_on_barrier(void (*hook)());
+
+// Runs handlers added for the irq, as if it fired, or later if masked
+void host_irq(unsigned num);
+
+// PIO model: loads a program from .pio source, then steps it one cycle
+// at a time, inputs are read from the given callback
+bool host_pio_load(const char *path, const char *program);
+void host_pio_clock();
+void host_pio_inputs(uint32_t (*read)());
+uint32_t host_pio_pins();
+uint32_t host_pio_pindirs();
+float host_pio_clkdiv();
+bool host_pio_get(uint32_t *data);
+
+// I2C model: MPR121 like chips on i2c0, DMA driven reads complete as
+// host_i2c_tick() moves time, see i2c.c
+#define HOST_I2C_MAX_DATA 48
+
+enum {
+    HOST_I2C_OK,
+    HOST_I2C_NAK, // address not acknowledged
+    HOST_I2C_HANG, // never completes, SDA held low
+};
+
+typedef struct {
+    uint8_t addr;
+    bool read;
+    uint8_t reg;
+    uint8_t len;
+    uint8_t data[HOST_I2C_MAX_DATA]; // written bytes
+    bool dma;
+    uint64_t time_us;
+} host_i2c_op_t;
+
+uint8_t *host_i2c_chip(uint8_t addr);
+void host_i2c_fault(uint8_t addr, int fault);
+// Above max_rate, one in every one_in reads has its last byte garbled
+void host_i2c_limit(uint8_t addr, uint32_t max_rate, int one_in);
+void host_i2c_tick();
+int host_i2c_ops(const host_i2c_op_t **ops);
+void host_i2c_clear_ops();
+// Electrodes autoconfig leaves out of range
+void host_i2c_broken(uint8_t addr, uint16_t electrodes);
+uint32_t host_i2c_autoconfigs(uint8_t addr);
+uint32_t host_i2c_ignored(uint8_t addr);
+uint32_t host_i2c_baudrate();
+
+#endif
@@ -0,0 +1,515 @@
+/*
+ * Chu Pico Host Tests, I2C bus model
+ * WHowe <github.com/whowechina>
+ * 
+ * MPR121 like chips on i2c0, each a register file with auto increment.
+ * ECR starts and stops the electrodes, registers from the baselines up
+ * only take writes while stopped, like the datasheet says. Measurements
+ * (touch status, filtered data, out of range) are up to the test.
+ * Transfers take bus time at the set baudrate. Blocking calls move the
+ * fake clock, DMA driven ones complete as host_i2c_tick() moves it.
+ * Above its rate limit a chip garbles one in every few reads, like a bus
+ * too slow to settle at that speed. Autoconfig brings every electrode in
+ * range but the broken ones.
+ */
+
+#include "host.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "pico/time.h"
+#include "hardware/i2c.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+#define MAX_CHIPS 4
+#define MAX_OPS 256
+#define MAX_DMA 4
+#define DREQ_I2C0_TX 32
+#define DREQ_I2C0_RX 33
+#define ABRT_7B_ADDR_NOACK 0x01
+
+#define REG_OOR 0x02
+#define REG_FILTERED 0x04
+#define REG_BASELINE 0x1E
+#define REG_ECR 0x5E
+#define REG_ACC 0x7B
+#define REG_RESET 0x80
+
+static struct {
+    uint8_t addr;
+    uint8_t regs[256];
+    uint8_t ptr;
+    int fault;
+    uint32_t max_rate;
+    int one_in;
+    int reads;
+    uint16_t broken;
+    uint32_t autoconfigs;
+    uint32_t ignored;
+} chips[MAX_CHIPS];
+static int chip_num = 0;
+
+static i2c_hw_t hw;
+i2c_inst_t host_i2c0 = { &hw };
+static uint32_t baudrate = 100000;
+
+static host_i2c_op_t ops[MAX_OPS];
+static int op_num = 0;
+
+static int find_chip(uint8_t addr)
+{
+    for (int i = 0; i < chip_num; i++) {
+        if (chips[i].addr == addr) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void soft_reset(int id)
+{
+    uint8_t *regs = chips[id].regs;
+    memset(regs + REG_BASELINE, 0, sizeof(chips[id].regs) - REG_BASELINE);
+    regs[0x5C] = 0x10;
+    regs[0x5D] = 0x24;
+}
+
+uint8_t *host_i2c_chip(uint8_t addr)
+{
+    int id = find_chip(addr);
+    if (id < 0) {
+        if (chip_num >= MAX_CHIPS) {
+            return NULL;
+        }
+        id = chip_num++;
+        chips[id].addr = addr;
+        chips[id].max_rate = UINT32_MAX;
+        soft_reset(id);
+    }
+    return chips[id].regs;
+}
+
+void host_i2c_fault(uint8_t addr, int fault)
+{
+    int id = find_chip(addr);
+    if (id >= 0) {
+        chips[id].fault = fault;
+    }
+}
+
+void host_i2c_limit(uint8_t addr, uint32_t max_rate, int one_in)
+{
+    int id = find_chip(addr);
+    if (id >= 0) {
+        chips[id].max_rate = max_rate;
+        chips[id].one_in = one_in;
+        chips[id].reads = 0;
+    }
+}
+
+void host_i2c_broken(uint8_t addr, uint16_t electrodes)
+{
+    int id = find_chip(addr);
+    if (id >= 0) {
+        chips[id].broken = electrodes;
+    }
+}
+
+uint32_t host_i2c_autoconfigs(uint8_t addr)
+{
+    int id = find_chip(addr);
+    return id < 0 ? 0 : chips[id].autoconfigs;
+}
+
+uint32_t host_i2c_ignored(uint8_t addr)
+{
+    int id = find_chip(addr);
+    return id < 0 ? 0 : chips[id].ignored;
+}
+
+uint32_t host_i2c_baudrate()
+{
+    return baudrate;
+}
+
+int host_i2c_ops(const host_i2c_op_t **log)
+{
+    *log = ops;
+    return op_num;
+}
+
+void host_i2c_clear_ops()
+{
+    op_num = 0;
+}
+
+static void log_op(uint8_t addr, bool read, uint8_t reg, const uint8_t *data,
+                   int len, bool dma)
+{
+    if (op_num >= MAX_OPS) {
+        return;
+    }
+    host_i2c_op_t *op = &ops[op_num++];
+    memset(op, 0, sizeof(*op));
+    op->addr = addr;
+    op->read = read;
+    op->reg = reg;
+    op->len = len;
+    op->dma = dma;
+    op->time_us = time_us_64();
+    if (data) {
+        memcpy(op->data, data, len < HOST_I2C_MAX_DATA ? len : HOST_I2C_MAX_DATA);
+    }
+}
+
+// 9 clocks a byte, address byte included
+static uint64_t bus_us(int bytes)
+{
+    return (bytes * 9 * 1000000ULL + baudrate - 1) / baudrate;
+}
+
+// Baselines from filtered data, CL or BVA 2 takes the 5 MSB, 3 takes all
+static void load_baselines(int id, int mode)
+{
+    uint8_t *regs = chips[id].regs;
+    for (int i = 0; i < 13; i++) {
+        uint16_t filtered = regs[REG_FILTERED + i * 2] |
+                            (regs[REG_FILTERED + i * 2 + 1] << 8);
+        uint8_t baseline = filtered >> 2;
+        regs[REG_BASELINE + i] = (mode == 2) ? baseline & 0xf8 : baseline;
+    }
+}
+
+// Stop to run transition, ACE set runs autoconfig
+static void start(int id)
+{
+    uint8_t *regs = chips[id].regs;
+    int mode = regs[REG_ECR] >> 6;
+    if (regs[REG_ACC] & 0x01) {
+        chips[id].autoconfigs++;
+        regs[REG_OOR] = chips[id].broken & 0xff;
+        regs[REG_OOR + 1] = chips[id].broken >> 8;
+        mode = (regs[REG_ACC] >> 2) & 0x03;
+    }
+    if (mode >= 2) {
+        load_baselines(id, mode);
+    }
+}
+
+static void write_byte(int id, uint8_t reg, uint8_t val)
+{
+    uint8_t *regs = chips[id].regs;
+    bool running = regs[REG_ECR] & 0x3f;
+    if (reg == REG_RESET) {
+        if (val == 0x63) {
+            soft_reset(id);
+        }
+    } else if (reg == REG_ECR) {
+        regs[REG_ECR] = val;
+        if (!running && (val & 0x3f)) {
+            start(id);
+        }
+    } else if (running && (reg >= REG_BASELINE)) {
+        chips[id].ignored++;
+    } else if (reg >= REG_BASELINE) {
+        regs[reg] = val;
+    }
+}
+
+static uint8_t read_byte(int id)
+{
+    return chips[id].regs[chips[id].ptr++];
+}
+
+static void read_bytes(int id, volatile uint8_t *dst, int len)
+{
+    for (int i = 0; i < len; i++) {
+        dst[i] = read_byte(id);
+    }
+    if ((baudrate > chips[id].max_rate) &&
+        (++chips[id].reads % chips[id].one_in == 0)) {
+        dst[len - 1] ^= 0x01;
+    }
+}
+
+/* Common start of a blocking transfer: returns chip id, or a PICO_ERROR
+ * code with the clock moved to when the transfer gave up. */
+static int begin(uint8_t addr, int bytes, absolute_time_t until)
+{
+    int id = find_chip(addr);
+    int fault = (id < 0) ? HOST_I2C_NAK : chips[id].fault;
+    uint64_t now = time_us_64();
+    if (fault == HOST_I2C_NAK) {
+        host_set_time(now + bus_us(1));
+        return PICO_ERROR_GENERIC;
+    }
+    if ((fault == HOST_I2C_HANG) || (now + bus_us(bytes) > until)) {
+        host_set_time(until > now ? until : now);
+        return PICO_ERROR_TIMEOUT;
+    }
+    host_set_time(now + bus_us(bytes));
+    return id;
+}
+
+int i2c_write_blocking_until(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src,
+                             size_t len, bool nostop, absolute_time_t until)
+{
+    int id = begin(addr, len + 1, until);
+    if (id < 0) {
+        return id;
+    }
+    chips[id].ptr = src[0];
+    if ((len == 1) && nostop) {
+        return 1; // register for the read to follow
+    }
+    log_op(addr, false, src[0], src + 1, len - 1, false);
+    for (size_t i = 1; i < len; i++) {
+        write_byte(id, chips[id].ptr++, src[i]);
+    }
+    return len;
+}
+
+int i2c_read_blocking_until(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst,
+                            size_t len, bool nostop, absolute_time_t until)
+{
+    int id = begin(addr, len + 1, until);
+    if (id < 0) {
+        return id;
+    }
+    log_op(addr, true, chips[id].ptr, NULL, len, false);
+    read_bytes(id, dst, len);
+    return len;
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint rate)
+{
+    baudrate = rate;
+    hw.enable = 1;
+    return rate;
+}
+
+void i2c_deinit(i2c_inst_t *i2c)
+{
+    hw.enable = 0;
+}
+
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint rate)
+{
+    baudrate = rate;
+    return rate;
+}
+
+uint i2c_get_dreq(i2c_inst_t *i2c, bool is_tx)
+{
+    return is_tx ? DREQ_I2C0_TX : DREQ_I2C0_RX;
+}
+
+/* DMA channels paced by I2C0, TX feeds IC_DATA_CMD with a register write
+ * then read commands, RX takes the data. One transfer is on the wire at
+ * a time, it completes at done_us. */
+static struct {
+    dma_channel_config cfg;
+    volatile void *write_addr;
+    const volatile void *read_addr;
+    uint32_t count;
+    bool busy;
+    bool irq1_enabled;
+    bool irq1_status;
+} dma[MAX_DMA];
+static int dma_num = 0;
+
+static struct {
+    bool active;
+    int tx;
+    uint8_t addr;
+    uint8_t reg;
+    int len;
+    bool nak;
+    uint64_t done_us;
+} wire;
+
+static int rx_channel()
+{
+    for (int i = 0; i < dma_num; i++) {
+        if (dma[i].busy && (dma[i].cfg.dreq == DREQ_I2C0_RX)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void dma_start(uint channel)
+{
+    dma[channel].busy = true;
+    if ((dma[channel].cfg.dreq != DREQ_I2C0_TX) || !hw.enable ||
+        !(hw.dma_cr & I2C_IC_DMA_CR_TDMAE_BITS)) {
+        return; // no DREQ, nothing moves
+    }
+
+    const uint32_t *cmds = (const uint32_t *)dma[channel].read_addr;
+    int len = 0;
+    for (uint32_t i = 1; i < dma[channel].count; i++) {
+        if (cmds[i] & I2C_IC_DATA_CMD_CMD_BITS) {
+            len++;
+        }
+    }
+
+    int id = find_chip(hw.tar);
+    int fault = (id < 0) ? HOST_I2C_NAK : chips[id].fault;
+    hw.tx_abrt_source = 0;
+    wire.active = true;
+    wire.tx = channel;
+    wire.addr = hw.tar;
+    wire.reg = cmds[0] & 0xff;
+    wire.len = len;
+    wire.nak = (fault == HOST_I2C_NAK);
+    if (fault == HOST_I2C_HANG) {
+        wire.done_us = UINT64_MAX;
+    } else if (wire.nak) {
+        wire.done_us = time_us_64() + bus_us(1);
+    } else {
+        wire.done_us = time_us_64() + bus_us(len + 3);
+    }
+    log_op(wire.addr, true, wire.reg, NULL, len, true);
+}
+
+static void wire_complete()
+{
+    wire.active = false;
+    if (wire.nak) {
+        hw.tx_abrt_source = ABRT_7B_ADDR_NOACK; // TX channel stalls
+        return;
+    }
+
+    int rx = rx_channel();
+    int id = find_chip(wire.addr);
+    chips[id].ptr = wire.reg;
+    uint8_t data[256];
+    read_bytes(id, data, wire.len);
+    for (int i = 0; (rx >= 0) && (i < wire.len) && (i < dma[rx].count); i++) {
+        ((volatile uint8_t *)dma[rx].write_addr)[i] = data[i];
+    }
+    dma[wire.tx].busy = false;
+    dma[wire.tx].count = 0;
+    if (rx < 0) {
+        return;
+    }
+    dma[rx].busy = false;
+    dma[rx].count = 0;
+    if (dma[rx].irq1_enabled) {
+        dma[rx].irq1_status = true;
+        host_irq(DMA_IRQ_1);
+    }
+}
+
+void host_i2c_tick()
+{
+    host_set_time(time_us_64() + 1);
+    if (wire.active && (time_us_64() >= wire.done_us)) {
+        wire_complete();
+    }
+}
+
+int dma_claim_unused_channel(bool required)
+{
+    return dma_num < MAX_DMA ? dma_num++ : -1;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+    dma_channel_config c = { DMA_SIZE_32, true, false, 0x3f };
+    return c;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config,
+                           volatile void *write_addr,
+                           const volatile void *read_addr,
+                           uint transfer_count, bool trigger)
+{
+    dma[channel].cfg = *config;
+    dma[channel].write_addr = write_addr;
+    dma[channel].read_addr = read_addr;
+    dma[channel].count = transfer_count;
+    if (trigger) {
+        dma_start(channel);
+    }
+}
+
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr,
+                                bool trigger)
+{
+    dma[channel].write_addr = write_addr;
+    if (trigger) {
+        dma_start(channel);
+    }
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr,
+                               bool trigger)
+{
+    dma[channel].read_addr = read_addr;
+    if (trigger) {
+        dma_start(channel);
+    }
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count,
+                                 bool trigger)
+{
+    dma[channel].count = trans_count;
+    if (trigger) {
+        dma_start(channel);
+    }
+}
+
+void dma_channel_abort(uint channel)
+{
+    dma[channel].busy = false;
+    if (wire.active && (wire.tx == channel)) {
+        wire.active = false;
+    }
+}
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled)
+{
+    dma[channel].irq1_enabled = enabled;
+}
+
+bool dma_channel_get_irq1_status(uint channel)
+{
+    return dma[channel].irq1_status;
+}
+
+void dma_channel_acknowledge_irq1(uint channel)
+{
+    dma[channel].irq1_status = false;
+}
+
+void gpio_init(uint gpio)
+{
+}
+
+void gpio_set_dir(uint gpio, bool out)
+{
+}
+
+void gpio_put(uint gpio, bool value)
+{
+}
+
+bool gpio_get(uint gpio)
+{
+    return true; // pulled up
+}
+
+void gpio_pull_up(uint gpio)
+{
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn)
+{
+}
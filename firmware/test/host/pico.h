@@ -0,0 +1,26 @@
+/*
+ * Chu Pico Host Tests, pico.h stand-in
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef HOST_PICO_H
+#define HOST_PICO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#define tight_loop_contents() host_spin()
+
+#define PICO_ERROR_GENERIC -1
+#define PICO_ERROR_TIMEOUT -2
+
+void host_spin();
+
+// Moves the fake clock, nothing else runs meanwhile
+void busy_wait_us(uint64_t delay_us);
+
+#endif
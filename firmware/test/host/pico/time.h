@@ -0,0 +1,16 @@
+/*
+ * Chu Pico Host Tests, pico/time.h stand-in
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+#include <stdint.h>
+
+typedef uint64_t absolute_time_t;
+
+uint64_t time_us_64();
+uint32_t time_us_32();
+
+#endif
@@ -0,0 +1,500 @@
+/*
+ * Chu Pico Host Tests, PIO model
+ * WHowe <github.com/whowechina>
+ * 
+ * Runs one program straight from its .pio source on a single state machine,
+ * one instruction per cycle like the hardware. Only the instructions and
+ * directives the firmware uses are known, anything else fails the load.
+ */
+
+#include "host.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+#include "hardware/pio.h"
+
+pio_hw_t host_pio_hw[2];
+
+#define MAX_INST 32
+#define MAX_LABELS 32
+#define FIFO_DEPTH 4
+
+enum op { OP_JMP, OP_IN, OP_PUSH, OP_PULL, OP_MOV, OP_SET };
+enum cond { COND_ALWAYS, COND_X_DEC, COND_Y_DEC, COND_X_ZERO, COND_Y_ZERO };
+enum reg { REG_PINS, REG_PINDIRS, REG_X, REG_Y, REG_ISR, REG_OSR, REG_NULL };
+
+typedef struct {
+    enum op op;
+    int arg; // jmp condition, push/pull block, mov/set destination
+    int src; // jmp/set/in value, mov source
+    char target[32];
+    int side;
+    int delay;
+} inst_t;
+
+static struct {
+    inst_t prog[MAX_INST];
+    int len;
+    int wrap_target;
+    int wrap;
+    int side_bits;
+    bool side_pindirs;
+} program;
+
+static struct {
+    pio_sm_config cfg;
+    bool enabled;
+    int pc;
+    int delay;
+    uint32_t x, y, isr, osr;
+    int isr_count;
+    uint32_t tx[2 * FIFO_DEPTH], rx[2 * FIFO_DEPTH];
+    int tx_num, rx_num;
+    uint32_t pins, pindirs;
+} sm;
+
+static uint32_t (*read_inputs)() = NULL;
+
+static int tx_depth()
+{
+    return sm.cfg.join == PIO_FIFO_JOIN_RX ? 0 :
+           sm.cfg.join == PIO_FIFO_JOIN_TX ? 2 * FIFO_DEPTH : FIFO_DEPTH;
+}
+
+static int rx_depth()
+{
+    return sm.cfg.join == PIO_FIFO_JOIN_TX ? 0 :
+           sm.cfg.join == PIO_FIFO_JOIN_RX ? 2 * FIFO_DEPTH : FIFO_DEPTH;
+}
+
+static int parse_reg(const char *s)
+{
+    static const char *names[] = { "pins", "pindirs", "x", "y", "isr", "osr", "null" };
+    for (int i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(s, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int parse_cond(const char *s)
+{
+    static const char *names[] = { "", "x--", "y--", "!x", "!y" };
+    for (int i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(s, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Splits a line into words, commas are separators too */
+static int split(char *line, char *words[], int max)
+{
+    int n = 0;
+    for (char *w = strtok(line, " \t,"); w && (n < max); w = strtok(NULL, " \t,")) {
+        words[n++] = w;
+    }
+    return n;
+}
+
+static bool parse_inst(char *words[], int n, inst_t *inst)
+{
+    memset(inst, 0, sizeof(*inst));
+    inst->side = -1;
+
+    // trailing side and delay
+    while (n >= 1 && words[n - 1][0] == '[') {
+        inst->delay = atoi(words[n - 1] + 1);
+        n--;
+    }
+    if (n >= 3 && strcmp(words[n - 2], "side") == 0) {
+        inst->side = atoi(words[n - 1]);
+        n -= 2;
+    }
+
+    const char *op = words[0];
+    if (strcmp(op, "jmp") == 0 && (n == 2 || n == 3)) {
+        inst->op = OP_JMP;
+        inst->arg = parse_cond(n == 3 ? words[1] : "");
+        snprintf(inst->target, sizeof(inst->target), "%s", words[n - 1]);
+        return inst->arg >= 0;
+    }
+    if (strcmp(op, "in") == 0 && n == 3) {
+        inst->op = OP_IN;
+        inst->arg = parse_reg(words[1]);
+        inst->src = atoi(words[2]);
+        return inst->arg == REG_PINS && inst->src > 0 && inst->src <= 32;
+    }
+    if ((strcmp(op, "push") == 0 || strcmp(op, "pull") == 0) && n <= 2) {
+        inst->op = op[1] == 'u' && op[2] == 's' ? OP_PUSH : OP_PULL;
+        inst->arg = (n == 1) || (strcmp(words[1], "block") == 0);
+        return (n == 1) || inst->arg || (strcmp(words[1], "noblock") == 0);
+    }
+    if (strcmp(op, "mov") == 0 && n == 3) {
+        inst->op = OP_MOV;
+        inst->arg = parse_reg(words[1]);
+        inst->src = parse_reg(words[2]);
+        return inst->arg >= REG_X && inst->src >= 0;
+    }
+    if (strcmp(op, "set") == 0 && n == 3) {
+        inst->op = OP_SET;
+        inst->arg = parse_reg(words[1]);
+        inst->src = atoi(words[2]);
+        return inst->arg >= 0 && inst->arg <= REG_Y && inst->src < 32;
+    }
+    return false;
+}
+
+bool host_pio_load(const char *path, const char *name)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        printf("pio: can't open %s\n", path);
+        return false;
+    }
+
+    memset(&program, 0, sizeof(program));
+    program.wrap = -1;
+
+    struct { char name[32]; int pc; } labels[MAX_LABELS];
+    int label_num = 0;
+    bool inside = false;
+    bool ok = true;
+    char line[256];
+    int line_no = 0;
+
+    while (ok && fgets(line, sizeof(line), fp)) {
+        line_no++;
+        char *comment = strpbrk(line, ";\r\n");
+        if (comment) {
+            *comment = 0;
+        }
+        if (line[0] == '%') {
+            inside = false;
+            continue;
+        }
+
+        char *words[8];
+        int n = split(line, words, 8);
+        if (n == 0) {
+            continue;
+        }
+
+        if (strcmp(words[0], ".program") == 0) {
+            inside = (n == 2) && (strcmp(words[1], name) == 0);
+            continue;
+        }
+        if (!inside || strcmp(words[0], ".define") == 0) {
+            continue;
+        }
+
+        if (strcmp(words[0], ".side_set") == 0) {
+            program.side_bits = atoi(words[1]);
+            program.side_pindirs = (n == 3) && (strcmp(words[2], "pindirs") == 0);
+            ok = (n == 2) || program.side_pindirs;
+        } else if (strcmp(words[0], ".wrap_target") == 0) {
+            program.wrap_target = program.len;
+        } else if (strcmp(words[0], ".wrap") == 0) {
+            program.wrap = program.len - 1;
+        } else if (words[0][strlen(words[0]) - 1] == ':') {
+            ok = (n == 1) && (label_num < MAX_LABELS);
+            if (ok) {
+                snprintf(labels[label_num].name, sizeof(labels[0].name),
+                         "%.*s", (int)strlen(words[0]) - 1, words[0]);
+                labels[label_num].pc = program.len;
+                label_num++;
+            }
+        } else {
+            ok = (program.len < MAX_INST) &&
+                 parse_inst(words, n, &program.prog[program.len]);
+            // side-set without opt is on every instruction
+            ok = ok && ((program.side_bits == 0) ||
+                        (program.prog[program.len].side >= 0));
+            program.len++;
+        }
+    }
+    fclose(fp);
+
+    if (!ok) {
+        printf("pio: %s:%d not understood\n", path, line_no);
+        return false;
+    }
+    if (program.len == 0) {
+        printf("pio: no program %s in %s\n", name, path);
+        return false;
+    }
+    if (program.wrap < 0) {
+        program.wrap = program.len - 1;
+    }
+
+    for (int i = 0; i < program.len; i++) {
+        inst_t *inst = &program.prog[i];
+        if (inst->op != OP_JMP) {
+            continue;
+        }
+        inst->src = -1;
+        for (int l = 0; l < label_num; l++) {
+            if (strcmp(labels[l].name, inst->target) == 0) {
+                inst->src = labels[l].pc;
+            }
+        }
+        if (inst->src < 0) {
+            printf("pio: unknown label %s\n", inst->target);
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t mask(int bits)
+{
+    return bits >= 32 ? 0xffffffff : (1u << bits) - 1;
+}
+
+static void write_pins(uint32_t *pins, uint base, int count, uint32_t value)
+{
+    uint32_t m = mask(count) << base;
+    *pins = (*pins & ~m) | ((value << base) & m);
+}
+
+static uint32_t read_reg(int reg)
+{
+    switch (reg) {
+        case REG_PINS: return read_inputs ? read_inputs() >> sm.cfg.in_base : 0;
+        case REG_X: return sm.x;
+        case REG_Y: return sm.y;
+        case REG_ISR: return sm.isr;
+        case REG_OSR: return sm.osr;
+        default: return 0;
+    }
+}
+
+static bool push(bool block)
+{
+    if (sm.rx_num >= rx_depth()) {
+        if (block) {
+            return false;
+        }
+    } else {
+        sm.rx[sm.rx_num++] = sm.isr;
+    }
+    sm.isr = 0;
+    sm.isr_count = 0;
+    return true;
+}
+
+/* Executes the instruction at pc, false if it stalls */
+static bool execute(const inst_t *inst, int *next)
+{
+    switch (inst->op) {
+        case OP_JMP: {
+            bool take = true;
+            switch (inst->arg) {
+                case COND_X_DEC: take = sm.x != 0; sm.x--; break;
+                case COND_Y_DEC: take = sm.y != 0; sm.y--; break;
+                case COND_X_ZERO: take = sm.x == 0; break;
+                case COND_Y_ZERO: take = sm.y == 0; break;
+            }
+            if (take) {
+                *next = inst->src;
+            }
+            return true;
+        }
+        case OP_IN: {
+            uint32_t data = read_reg(inst->arg) & mask(inst->src);
+            if (sm.cfg.in_shift_right) {
+                sm.isr = inst->src >= 32 ? data :
+                         (sm.isr >> inst->src) | (data << (32 - inst->src));
+            } else {
+                sm.isr = inst->src >= 32 ? data : (sm.isr << inst->src) | data;
+            }
+            sm.isr_count += inst->src;
+            if (sm.isr_count > 32) {
+                sm.isr_count = 32;
+            }
+            if (sm.cfg.autopush && (sm.isr_count >= sm.cfg.push_threshold)) {
+                return push(true);
+            }
+            return true;
+        }
+        case OP_PUSH:
+            return push(inst->arg);
+        case OP_PULL:
+            if (sm.tx_num == 0) {
+                if (inst->arg) {
+                    return false;
+                }
+                sm.osr = sm.x;
+                return true;
+            }
+            sm.osr = sm.tx[0];
+            sm.tx_num--;
+            memmove(sm.tx, sm.tx + 1, sm.tx_num * sizeof(sm.tx[0]));
+            return true;
+        case OP_MOV: {
+            uint32_t value = read_reg(inst->src);
+            switch (inst->arg) {
+                case REG_X: sm.x = value; break;
+                case REG_Y: sm.y = value; break;
+                case REG_ISR: sm.isr = value; sm.isr_count = 0; break;
+                case REG_OSR: sm.osr = value; break;
+            }
+            return true;
+        }
+        case OP_SET:
+            switch (inst->arg) {
+                case REG_PINS:
+                    write_pins(&sm.pins, sm.cfg.set_base, sm.cfg.set_count, inst->src);
+                    break;
+                case REG_PINDIRS:
+                    write_pins(&sm.pindirs, sm.cfg.set_base, sm.cfg.set_count, inst->src);
+                    break;
+                case REG_X: sm.x = inst->src; break;
+                case REG_Y: sm.y = inst->src; break;
+            }
+            return true;
+    }
+    return true;
+}
+
+void host_pio_clock()
+{
+    if (!sm.enabled) {
+        return;
+    }
+    if (sm.delay > 0) {
+        sm.delay--;
+        return;
+    }
+
+    const inst_t *inst = &program.prog[sm.pc];
+    if (inst->side >= 0) {
+        // side-set takes effect even if the instruction stalls
+        write_pins(program.side_pindirs ? &sm.pindirs : &sm.pins,
+                   sm.cfg.sideset_base, program.side_bits, inst->side);
+    }
+
+    int next = (sm.pc == program.wrap) ? program.wrap_target : sm.pc + 1;
+    if (!execute(inst, &next)) {
+        return;
+    }
+    sm.pc = next;
+    sm.delay = inst->delay;
+}
+
+uint32_t host_pio_pins()
+{
+    return sm.pins;
+}
+
+uint32_t host_pio_pindirs()
+{
+    return sm.pindirs;
+}
+
+float host_pio_clkdiv()
+{
+    return sm.cfg.clkdiv;
+}
+
+void host_pio_inputs(uint32_t (*read)())
+{
+    read_inputs = read;
+}
+
+bool host_pio_get(uint32_t *data)
+{
+    if (sm.rx_num == 0) {
+        return false;
+    }
+    *data = sm.rx[0];
+    sm.rx_num--;
+    memmove(sm.rx, sm.rx + 1, sm.rx_num * sizeof(sm.rx[0]));
+    return true;
+}
+
+pio_sm_config host_pio_default_config(uint offset)
+{
+    return (pio_sm_config) {
+        .offset = offset,
+        .in_shift_right = true,
+        .push_threshold = 32,
+        .clkdiv = 1.0f,
+    };
+}
+
+void pio_gpio_init(PIO pio, uint pin)
+{
+}
+
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm_num, uint pin_base,
+                                    uint pin_count, bool is_out)
+{
+    write_pins(&sm.pindirs, pin_base, pin_count, is_out ? 0xffffffff : 0);
+}
+
+void sm_config_set_set_pins(pio_sm_config *c, uint set_base, uint set_count)
+{
+    c->set_base = set_base;
+    c->set_count = set_count;
+}
+
+void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base)
+{
+    c->sideset_base = sideset_base;
+}
+
+void sm_config_set_in_pins(pio_sm_config *c, uint in_base)
+{
+    c->in_base = in_base;
+}
+
+void sm_config_set_in_shift(pio_sm_config *c, bool shift_right,
+                            bool autopush, uint push_threshold)
+{
+    c->in_shift_right = shift_right;
+    c->autopush = autopush;
+    c->push_threshold = push_threshold;
+}
+
+void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join)
+{
+    c->join = join;
+}
+
+void sm_config_set_clkdiv(pio_sm_config *c, float div)
+{
+    c->clkdiv = div;
+}
+
+// Like the SDK, init clears the FIFOs and scratch registers
+void pio_sm_init(PIO pio, uint sm_num, uint initial_pc, const pio_sm_config *c)
+{
+    sm.cfg = *c;
+    sm.enabled = false;
+    sm.pc = initial_pc - c->offset;
+    sm.delay = 0;
+    sm.x = sm.y = sm.isr = sm.osr = 0;
+    sm.isr_count = 0;
+    sm.tx_num = sm.rx_num = 0;
+}
+
+// A put to a full (or joined away) TX FIFO is lost, as on the chip
+void pio_sm_put(PIO pio, uint sm_num, uint32_t data)
+{
+    if (sm.tx_num < tx_depth()) {
+        sm.tx[sm.tx_num++] = data;
+    }
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm_num, bool enabled)
+{
+    sm.enabled = enabled;
+}
@@ -0,0 +1,13 @@
+/*
+ * Chu Pico Host Tests, tusb.h stand-in
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef HOST_TUSB_H
+#define HOST_TUSB_H
+
+#include <stdbool.h>
+
+void tud_sof_cb_enable(bool enable);
+
+#endif
@@ -0,0 +1,18 @@
+/*
+ * Chu Pico Host Tests, USB registers and TinyUSB stand-ins
+ * WHowe <github.com/whowechina>
+ */
+
+#include "host.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hardware/structs/usb.h"
+#include "tusb.h"
+
+usb_hw_t host_usb_hw;
+
+void tud_sof_cb_enable(bool enable)
+{
+}
@@ -0,0 +1,28 @@
+/*
+ * Chu Pico Host Tests
+ * WHowe <github.com/whowechina>
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond)                                                           \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);   \
+            test_failures++;                                                  \
+        }                                                                     \
+    } while (0)
+
+#define RUN(test)                                                             \
+    do {                                                                      \
+        int before = test_failures;                                           \
+        test();                                                               \
+        printf("%s %s\n", test_failures == before ? "PASS" : "FAIL", #test);  \
+    } while (0)
+
+#endif
@@ -0,0 +1,177 @@
+/*
+ * Chu Pico Host Tests, PIO air scanner
+ * WHowe <github.com/whowechina>
+ * 
+ * Runs air.pio in the PIO model against a model of the LEDs and sensors:
+ * a sensor only sees its own LED, and only at the exact cycle its LED has
+ * been lit for AIR_LED_DELAY_US.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "host.h"
+#include "test.h"
+
+#include "board_defs.h"
+#include "air.pio.h"
+
+static const uint8_t IR_LED_LIST[] = IR_LED_PINS;
+static const uint8_t IR_SENSOR_LIST[] = IR_SENSOR_PINS;
+
+/* change_light(): the LED is between a driven high and a driven low pin */
+static const uint8_t LED_HIGH[6] = { 0, 1, 1, 2, 0, 2 };
+static const uint8_t LED_LOW[6] = { 1, 0, 2, 1, 2, 0 };
+
+static uint32_t led_mask;
+static uint32_t cycle;
+static uint32_t lit_since;
+static int lit;
+static uint8_t blocked;
+
+static int lit_led()
+{
+    uint32_t dirs = host_pio_pindirs() & led_mask;
+    uint32_t pins = host_pio_pins() & led_mask;
+    for (int i = 0; i < 6; i++) {
+        uint32_t high = 1u << IR_LED_LIST[LED_HIGH[i]];
+        uint32_t low = 1u << IR_LED_LIST[LED_LOW[i]];
+        if ((dirs == (high | low)) && (pins == high)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static uint32_t sensors()
+{
+    if ((lit < 0) || (cycle - lit_since != AIR_LED_DELAY_US) ||
+        (blocked & (1 << lit))) {
+        return 0;
+    }
+    return 1u << IR_SENSOR_LIST[lit];
+}
+
+static void clock()
+{
+    host_pio_clock();
+    int now = lit_led();
+    if (now != lit) {
+        lit = now;
+        lit_since = cycle;
+    }
+    cycle++;
+}
+
+static void start()
+{
+    led_mask = 0;
+    uint led_base = IR_LED_LIST[0];
+    for (int i = 0; i < 3; i++) {
+        led_mask |= 1u << IR_LED_LIST[i];
+        if (IR_LED_LIST[i] < led_base) {
+            led_base = IR_LED_LIST[i];
+        }
+    }
+    cycle = 0;
+    lit = -1;
+    blocked = 0;
+
+    CHECK(host_pio_load(AIR_PIO_FILE, "air_scan"));
+    host_pio_inputs(sensors);
+    air_scan_program_init(pio1, 0, 0, led_base, IR_SENSOR_LIST[0],
+                          AIR_LED_DELAY_US);
+    CHECK(host_pio_clkdiv() == 125.0f);
+}
+
+/* Every scan walks the 6 LEDs in order, each lit for the settle time
+ * plus the sample cycle, all off only before the first one */
+static void test_phases()
+{
+    start();
+
+    const uint32_t phase_cycles = AIR_LED_DELAY_US + 1;
+    int expect = -1;
+    uint32_t since = 0;
+    for (int i = 0; i < 3 * (6 * phase_cycles + 1); i++) {
+        int before = lit;
+        clock();
+        if (lit == before) {
+            continue;
+        }
+        if (expect >= 0) {
+            // the last phase also has the push
+            CHECK(cycle - 1 - since == phase_cycles + (expect == 5));
+        }
+        expect = (expect + 1) % 6;
+        CHECK(lit == expect);
+        since = cycle - 1;
+    }
+    CHECK(expect >= 0);
+}
+
+/* Sensors are sampled exactly AIR_LED_DELAY_US after their LED is lit */
+static void test_sample_timing()
+{
+    start();
+
+    uint32_t frames = 0;
+    uint32_t raw;
+    for (int i = 0; i < 10 * (6 * (AIR_LED_DELAY_US + 1) + 1); i++) {
+        clock();
+        while (host_pio_get(&raw)) {
+            CHECK(air_scan_decode(raw) == 0x3f);
+            frames++;
+        }
+    }
+    CHECK(frames >= 9);
+}
+
+/* Sensor i sampled in phase i lands at bit (30 - 5 * i) */
+static void test_decode()
+{
+    for (int i = 0; i < 6; i++) {
+        start();
+        blocked = 0x3f & ~(1 << i);
+
+        uint32_t raw = 0;
+        while (!host_pio_get(&raw) && (cycle < 1000)) {
+            clock();
+        }
+        CHECK(raw == 1u << (30 - 5 * i));
+        CHECK(air_scan_decode(raw) == 1 << i);
+    }
+}
+
+/* The scan keeps going, frames get dropped (not stalled) if not drained */
+static void test_free_running()
+{
+    start();
+
+    for (int i = 0; i < 20 * (6 * (AIR_LED_DELAY_US + 1) + 1); i++) {
+        clock();
+    }
+    uint32_t raw;
+    int got = 0;
+    while (host_pio_get(&raw)) {
+        got++;
+    }
+    CHECK(got == 4);
+
+    blocked = 0x01;
+    for (int i = 0; i < 2 * (6 * (AIR_LED_DELAY_US + 1) + 1); i++) {
+        clock();
+    }
+    CHECK(host_pio_get(&raw));
+    CHECK(host_pio_get(&raw));
+    CHECK(air_scan_decode(raw) == 0x3e);
+}
+
+int main()
+{
+    RUN(test_phases);
+    RUN(test_sample_timing);
+    RUN(test_decode);
+    RUN(test_free_running);
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * Chu Pico Host Tests, air debounce
+ * WHowe <github.com/whowechina>
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "test.h"
+#include "airfilter.h"
+
+static void test_airfilter()
+{
+    const uint8_t on[6] = { 2, 0, 7, 0, 0, 0 };
+    const uint8_t off[6] = { 0, 1, 0, 0, 0, 0 };
+    airfilter_config(on, off);
+
+    // sensor 0 turns on after 3 agreeing scans, sensor 1 after 1
+    CHECK(airfilter_step(0x03) == 0x02);
+    CHECK(airfilter_step(0x03) == 0x02);
+    CHECK(airfilter_step(0x03) == 0x03);
+
+    // a disagreeing scan restarts the count
+    CHECK(airfilter_step(0x00) == 0x02); // sensor 0 off at once, 1 waits
+    CHECK(airfilter_step(0x02) == 0x02);
+    CHECK(airfilter_step(0x00) == 0x02);
+    CHECK(airfilter_step(0x00) == 0x00);
+
+    // longest debounce is 8 scans
+    for (int i = 0; i < 7; i++) {
+        CHECK(airfilter_step(0x04) == 0x00);
+    }
+    CHECK(airfilter_step(0x04) == 0x04);
+    CHECK(airfilter_state() == 0x04);
+}
+
+int main()
+{
+    RUN(test_airfilter);
+    return test_failures ? 1 : 0;
+}
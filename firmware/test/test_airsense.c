@@ -0,0 +1,527 @@
+/*
+ * Chu Pico Host Tests, air sensing math
+ * WHowe <github.com/whowechina>
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "test.h"
+#include "board_defs.h"
+#include "config.h"
+#include "airsense.h"
+
+static void config_levels(uint8_t on, uint8_t off)
+{
+    for (int i = 0; i < 6; i++) {
+        chu_cfg->air.on_level[i] = on;
+        chu_cfg->air.off_level[i] = off;
+    }
+}
+
+static void feed(const uint16_t level[6], uint8_t frame, int frames)
+{
+    for (int i = 0; i < frames; i++) {
+        airsense_track(level, frame);
+    }
+}
+
+#define RING_SIZE 256
+
+static uint16_t ring[RING_SIZE];
+static uint32_t produced;
+
+/* Writes samples like the ADC DMA does, slot k % slots gets value[slot]
+ * plus some +-3 noise that averages out */
+static void adc_run(const uint16_t *value, int slots, int num)
+{
+    static const int noise[] = { 3, -3, 1, -1, 2, -2 };
+    for (int i = 0; i < num; i++, produced++) {
+        int slot = produced % slots;
+        ring[produced % RING_SIZE] = value[slot] + noise[(produced / slots) % 6];
+    }
+}
+
+static void test_average()
+{
+    const uint16_t value[3] = { 1000, 2000, 3000 };
+    uint16_t avg[4] = {0};
+
+    produced = 0;
+    adc_run(value, 3, 60);
+    CHECK(airsense_average(ring, RING_SIZE, 0, produced, 0, 3, avg) == 0x07);
+    CHECK(avg[0] == 1000);
+    CHECK(avg[1] == 2000);
+    CHECK(avg[2] == 3000);
+
+    // nothing new, or nothing past the settle samples
+    CHECK(airsense_average(ring, RING_SIZE, produced, produced, 0, 3, avg) == 0);
+    uint32_t consumed = produced;
+    adc_run(value, 3, 10);
+    CHECK(airsense_average(ring, RING_SIZE, consumed, produced, 10, 3, avg) == 0);
+    CHECK(airsense_average(ring, RING_SIZE, consumed, produced, 12, 3, avg) == 0);
+
+    // only the last sample is past settling, only its slot gets a value
+    avg[0] = avg[1] = avg[2] = 0;
+    CHECK(airsense_average(ring, RING_SIZE, consumed, produced, 9, 3, avg) ==
+          1 << ((produced - 1) % 3));
+}
+
+/* Samples while the LED settles are dropped, they would drag averages */
+static void test_average_settle()
+{
+    const uint16_t dark[2] = { 100, 100 };
+    const uint16_t lit[2] = { 1500, 900 };
+    uint16_t avg[4];
+
+    produced = 1000;
+    uint32_t consumed = produced;
+    adc_run(dark, 2, 12);
+    adc_run(lit, 2, 50);
+    CHECK(airsense_average(ring, RING_SIZE, consumed, produced, 12, 2, avg) == 0x03);
+    CHECK(avg[0] == 1500);
+    CHECK(avg[1] == 900);
+
+    // without skipping, the settling part pulls it down
+    CHECK(airsense_average(ring, RING_SIZE, consumed, produced, 0, 2, avg) == 0x03);
+    CHECK(avg[0] < 1500 - 100);
+}
+
+/* Fell behind more than a ring: only samples still in the ring count */
+static void test_average_overrun()
+{
+    const uint16_t old[4] = { 10, 10, 10, 10 };
+    const uint16_t now[4] = { 400, 500, 600, 700 };
+    uint16_t avg[4];
+
+    produced = 0xffffff00; // counts wrap on the way
+    uint32_t consumed = produced;
+    adc_run(old, 4, 3 * RING_SIZE);
+    adc_run(now, 4, RING_SIZE);
+    CHECK(airsense_average(ring, RING_SIZE, consumed, produced, 4, 4, avg) == 0x0f);
+    CHECK(avg[0] == 400);
+    CHECK(avg[3] == 700);
+}
+
+/* Fake LEDs and sensors for the scan: a tick takes the level of the
+ * phase lit since the tick before, like scan_tick() does */
+static uint8_t scan_blocked;
+static int scan_lit;
+static uint64_t scan_lit_at;
+static uint64_t scan_now;
+
+#ifdef IR_SENSOR_DIFFERENTIAL
+#define PHASES 7
+#else
+#define PHASES 6
+#endif
+
+static uint16_t scan_level(int phase)
+{
+    if (phase >= 6) {
+        return 0; // dark phase
+    }
+    return (scan_blocked & (1 << phase)) ? 300 : 1000;
+}
+
+static bool scan_tick(uint8_t filtered, uint8_t *frame)
+{
+    bool done = false;
+    int phase = airsense_scan_phase();
+    if (phase < 0) {
+        airsense_scan_start();
+    } else {
+        CHECK(phase == scan_lit);
+        CHECK(scan_now - scan_lit_at == AIR_LED_DELAY_US);
+        done = airsense_scan_next(scan_level(phase), filtered, frame);
+    }
+    scan_lit = airsense_scan_phase();
+    scan_lit_at = scan_now;
+    scan_now += AIR_LED_DELAY_US;
+    return done;
+}
+
+static void scan_reset()
+{
+    airsense_init();
+    config_levels(90, 93);
+    scan_blocked = 0;
+    scan_lit = -1;
+    scan_now = 0;
+}
+
+/* Phases run in order one per tick, a frame every PHASES ticks */
+static void test_scan_cadence()
+{
+    scan_reset();
+    CHECK(airsense_scan_phase() == -1);
+
+    uint8_t frame = 0xff;
+    CHECK(!scan_tick(0, &frame)); // lights LED 0, nothing to take yet
+    CHECK(scan_lit == 0);
+
+    uint64_t last_frame = 0;
+    int frames = 0;
+    for (int i = 0; i < PHASES * 50; i++) {
+        int expect = (scan_lit + 1) % PHASES;
+        uint64_t now = scan_now;
+        if (scan_tick(0, &frame)) {
+            CHECK(frame == 0);
+            if (frames > 0) {
+                CHECK(now - last_frame == PHASES * AIR_LED_DELAY_US);
+            }
+            last_frame = now;
+            frames++;
+        }
+        CHECK(scan_lit == expect);
+    }
+    CHECK(frames == 50);
+    CHECK(airsense_reading(3) == 1000);
+}
+
+static void scan_frames(uint8_t filtered, int num, uint8_t *frame)
+{
+    while (num > 0) {
+        num -= scan_tick(filtered, frame);
+    }
+}
+
+/* A whole frame with sensor 5 at level, the rest clear */
+static uint8_t scan_one(uint16_t level, uint8_t filtered)
+{
+    uint8_t frame = 0xff;
+    airsense_scan_start();
+    for (int phase = 0; phase < PHASES; phase++) {
+        uint16_t value = (phase == 5) ? level : scan_level(phase);
+        CHECK(airsense_scan_next(value, filtered, &frame) == (phase == PHASES - 1));
+    }
+    return frame;
+}
+
+/* Frames have the bits of sensors below threshold, with hysteresis */
+static void test_scan_frame()
+{
+    scan_reset();
+    uint8_t frame;
+    scan_frames(0, SKIP_SAMPLES, &frame);
+    CHECK(airsense_baseline(0) == 1000);
+
+    scan_blocked = 0x24;
+    scan_frames(0, 1, &frame);
+    CHECK(frame == 0x24);
+    CHECK(airsense_reading(2) == 300);
+    scan_blocked = 0;
+
+    // between on (900) and off (930) it depends on the filtered state
+    CHECK(scan_one(920, 0x00) == 0x00);
+    CHECK(scan_one(920, 0x20) == 0x20);
+    CHECK(scan_one(880, 0x00) == 0x20);
+    CHECK(scan_one(940, 0x20) == 0x00);
+}
+
+/* Stopping (LED held for testing) drops the frame being built, the scan
+ * restarts from LED 0 */
+static void test_scan_stop()
+{
+    scan_reset();
+    uint8_t frame;
+    scan_tick(0, &frame);
+    scan_blocked = 0x01;
+    scan_tick(0, &frame);
+    scan_tick(0, &frame);
+    CHECK(scan_lit == 2);
+
+    airsense_scan_stop();
+    CHECK(airsense_scan_phase() == -1);
+    CHECK(!airsense_scan_next(1000, 0, &frame));
+
+    scan_blocked = 0;
+    scan_lit = -1;
+    CHECK(!scan_tick(0, &frame));
+    CHECK(scan_lit == 0);
+    int ticks = 0;
+    while (!scan_tick(0, &frame)) {
+        ticks++;
+    }
+    CHECK(ticks == PHASES - 1);
+    CHECK(frame == 0);
+}
+
+static void test_lit()
+{
+    airsense_init();
+    CHECK(airsense_lit(2, 800) == 800);
+    airsense_dark(2, 300);
+    CHECK(airsense_lit(2, 800) == 500);
+    CHECK(airsense_lit(2, 200) == 0);
+    CHECK(airsense_lit(3, 800) == 800);
+}
+
+/* Stage lights: ambient pans between 400 and 1400 every 4 seconds, with
+ * +-150 of 100Hz flicker on top. The LED adds 1000, a hand cuts that to
+ * 200, for half a second every 10 seconds. Frames are 350us with the dark
+ * phase at the end, the worst sensor is sampled 300us after it.
+ * Sensor 0 thresholds the plain level, sensor 1 the differential one. */
+static double stage_light(double t)
+{
+    double pan = fmod(t, 4.0);
+    pan = pan < 2.0 ? pan / 2.0 : (4.0 - pan) / 2.0;
+    return 400 + 1000 * pan + 150 * sin(2 * M_PI * 100 * t);
+}
+
+static void test_ambient_replay()
+{
+    const double frame = 350e-6;
+    const uint32_t frames = 61 / frame;
+
+    airsense_init();
+    config_levels(90, 93);
+
+    uint32_t false_on[2] = {0};
+    uint32_t hands = 0;
+    uint32_t caught = 0;
+    bool on[2] = {false};
+    bool seen = false;
+    bool was_present = false;
+    double dark = stage_light(0);
+
+    for (uint32_t f = 0; f < frames; f++) {
+        double t = f * frame;
+        bool present = fmod(t, 10.0) >= 9.5;
+        double ambient = stage_light(t + 300e-6);
+        double led = present ? 200 : 1000;
+
+        uint16_t plain = ambient + led;
+        airsense_dark(1, dark);
+        uint16_t level[6] = { plain, airsense_lit(1, plain), 0, 0, 0, 0 };
+        uint8_t bits = 0;
+        for (int i = 0; i < 2; i++) {
+            on[i] = level[i] < airsense_threshold(i, !on[i]);
+            bits |= on[i] << i;
+            false_on[i] += on[i] && !present;
+        }
+        airsense_track(level, bits);
+        dark = stage_light(t + frame);
+
+        if (present) {
+            seen |= on[1];
+        } else if (was_present) {
+            hands++;
+            caught += seen;
+            seen = false;
+        }
+        was_present = present;
+    }
+
+    CHECK(false_on[0] > 1000); // plain level can't keep up
+    CHECK(false_on[1] == 0);
+    CHECK(hands == 6);
+    CHECK(caught == hands);
+}
+
+/* Baselines start from the readings after the first SKIP_SAMPLES frames */
+static void test_track_seed()
+{
+    airsense_init();
+    config_levels(90, 93);
+
+    uint16_t wild[6] = { 4000, 0, 4000, 0, 4000, 0 };
+    feed(wild, 0, SKIP_SAMPLES - 1);
+    CHECK(airsense_baseline(0) == 0);
+
+    uint16_t level[6] = { 1000, 1100, 1200, 1300, 1400, 1500 };
+    feed(level, 0, 1);
+    for (int i = 0; i < 6; i++) {
+        CHECK(airsense_baseline(i) == level[i]);
+        CHECK(airsense_threshold(i, true) == level[i] * 90 / 100);
+        CHECK(airsense_threshold(i, false) == level[i] * 93 / 100);
+    }
+
+    config_levels(50, 60);
+    airsense_update_thresholds();
+    CHECK(airsense_threshold(1, true) == 550);
+    CHECK(airsense_threshold(1, false) == 660);
+    CHECK(airsense_threshold(6, true) == 0);
+}
+
+static void seed(uint16_t value)
+{
+    airsense_init();
+    config_levels(90, 93);
+    uint16_t level[6] = { value, value, value, value, value, value };
+    feed(level, 0, SKIP_SAMPLES);
+}
+
+/* Follows drift while clear, rising faster than falling */
+static void test_track_drift()
+{
+    seed(1000);
+    uint16_t level[6] = { 1100, 900, 1000, 1000, 1000, 1000 };
+
+    // one update every 64 frames
+    feed(level, 0, 63);
+    CHECK(airsense_baseline(0) == 1000);
+    feed(level, 0, 1);
+    CHECK(airsense_baseline(0) == 1025); // 1/4 of the way up
+    CHECK(airsense_baseline(1) == 999); // 1/256 of the way down
+
+    feed(level, 0, 64 * 40);
+    CHECK(airsense_baseline(0) >= 1099); // fraction left below 1/4 step
+    CHECK(airsense_baseline(1) < 990);
+    CHECK(airsense_baseline(1) > 980);
+    CHECK(airsense_threshold(0, true) == airsense_baseline(0) * 90 / 100);
+}
+
+/* Frozen while blocked, taken as a new baseline if blocked for too long */
+static void test_track_blocked()
+{
+    seed(1000);
+    uint16_t level[6] = { 300, 1000, 1000, 1000, 1000, 1000 };
+
+    feed(level, 0x01, 64 * 499);
+    CHECK(airsense_baseline(0) == 1000);
+    CHECK(airsense_baseline(1) == 1000);
+    feed(level, 0x01, 64);
+    CHECK(airsense_baseline(0) == 300);
+
+    // a short block doesn't count towards the next resync
+    seed(1000);
+    feed(level, 0x01, 64 * 400);
+    level[0] = 1000;
+    feed(level, 0x00, 64);
+    level[0] = 300;
+    feed(level, 0x01, 64 * 400);
+    CHECK(airsense_baseline(0) == 1000);
+}
+
+/* An hour of a sensor drifting down by 40% and back (warm up, sunlight),
+ * a hand over it for half a second every minute. Frames are 350us. The
+ * sensor must only trigger while the hand is there. */
+static void test_track_hour()
+{
+    const uint32_t frame_us = 350;
+    const uint32_t frames = 3600ULL * 1000000 / frame_us;
+    const uint32_t minute = 60 * 1000000 / frame_us;
+    const uint32_t hand = 500000 / frame_us;
+
+    seed(2000);
+    uint32_t false_on = 0;
+    uint32_t missed = 0;
+    bool on = false;
+    bool seen = false;
+
+    for (uint32_t f = 0; f < frames; f++) {
+        uint32_t half = frames / 2;
+        uint32_t drift = (f < half ? f : frames - f) * 800ULL / half;
+        uint16_t clear = 2000 - drift;
+        bool present = (f % minute) >= minute - hand;
+        uint16_t value = present ? clear * 3 / 10 : clear;
+
+        uint16_t level[6] = { value, clear, clear, clear, clear, clear };
+        // hysteresis like the scan does
+        on = value < airsense_threshold(0, !on);
+        airsense_track(level, on ? 0x01 : 0x00);
+
+        if (on && !present) {
+            false_on++;
+        }
+        if (present) {
+            seen |= on;
+        } else if ((f % minute) == 0) {
+            if (f > 0 && !seen) {
+                missed++;
+            }
+            seen = false;
+        }
+    }
+    CHECK(false_on == 0);
+    CHECK(missed == 0);
+}
+
+static void test_weight()
+{
+    // base 1000, on level 600
+    CHECK(airsense_weight(1000, 1000, 600) == 0);
+    CHECK(airsense_weight(1100, 1000, 600) == 0);
+    CHECK(airsense_weight(800, 1000, 600) == 128);
+    CHECK(airsense_weight(600, 1000, 600) == 256);
+    CHECK(airsense_weight(100, 1000, 600) == 256);
+    // no baseline yet
+    CHECK(airsense_weight(100, 0, 0) == 0);
+}
+
+/* Digital sensors weigh 256 when blocked, height is the highest one */
+static void test_height_digital()
+{
+    uint16_t full[6] = { 256, 256, 256, 256, 256, 256 };
+    CHECK(airsense_height(0x00, full) == 0);
+
+    for (int i = 0; i < 6; i++) {
+        uint8_t expect = (i + 1) * 255 / 6;
+        uint8_t frame = 1 << i;
+        uint8_t below = (1 << i) - 1;
+        uint16_t weight[6] = {0};
+        for (int j = 0; j <= i; j++) {
+            weight[j] = 256;
+        }
+        CHECK(airsense_height(frame, weight) == expect);
+        CHECK(airsense_height(frame | below, weight) == expect);
+    }
+    CHECK(airsense_height(0x3f, full) == 255);
+}
+
+/* Weights move the height between levels of the highest blocked sensor */
+static void test_height_analog()
+{
+    const uint8_t level2 = 2 * 255 / 6;
+    const uint8_t level3 = 3 * 255 / 6;
+
+    // hand up to sensor 1, sensor 2 half covered
+    uint16_t weight[6] = { 256, 256, 128, 0, 0, 0 };
+    uint8_t h = airsense_height(0x03, weight);
+    CHECK(h > level2);
+    CHECK(h < level3);
+    CHECK(h == (2 * 256 + 128) * 255 / (6 * 256));
+
+    // lower sensors don't pull it down, it's not a centroid
+    uint16_t low[6] = { 0, 256, 128, 0, 0, 0 };
+    CHECK(airsense_height(0x03, low) == h);
+
+    // sensors above the next one don't count
+    weight[4] = 256;
+    CHECK(airsense_height(0x03, weight) == h);
+
+    // highest blocked sensor only partly in (held by hysteresis)
+    uint16_t partial[6] = { 256, 64, 0, 0, 0, 0 };
+    h = airsense_height(0x03, partial);
+    CHECK(h == (256 + 64) * 255 / (6 * 256));
+
+    // never reads as not present while blocked
+    uint16_t none[6] = {0};
+    CHECK(airsense_height(0x01, none) == 1);
+
+    // top sensor maxes out
+    uint16_t top[6] = { 0, 0, 0, 0, 0, 256 };
+    CHECK(airsense_height(0x20, top) == 255);
+}
+
+int main()
+{
+    RUN(test_scan_cadence);
+    RUN(test_scan_frame);
+    RUN(test_scan_stop);
+    RUN(test_average);
+    RUN(test_average_settle);
+    RUN(test_average_overrun);
+    RUN(test_lit);
+    RUN(test_ambient_replay);
+    RUN(test_track_seed);
+    RUN(test_track_drift);
+    RUN(test_track_blocked);
+    RUN(test_track_hour);
+    RUN(test_weight);
+    RUN(test_height_digital);
+    RUN(test_height_analog);
+    return test_failures ? 1 : 0;
+}
@@ -0,0 +1,35 @@
+/*
+ * Chu Pico Host Tests, autotune picks
+ * WHowe <github.com/whowechina>
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "test.h"
+#include "autotune.h"
+
+// autotune.c talks to the slider, not exercised here
+static uint16_t slider_values[32];
+const uint16_t *slider_raw() { return slider_values; }
+const uint16_t *slider_baseline() { return slider_values; }
+void slider_filter_override(int filter) {}
+
+static void test_autotune_pick()
+{
+    const uint32_t quiet_first[] = { 100, 90, 80, 200 };
+    CHECK(autotune_pick_filter(quiet_first, 4) == 0); // within 25% + 32
+    const uint32_t noisy_first[] = { 500, 90, 80, 200 };
+    CHECK(autotune_pick_filter(noisy_first, 4) == 1);
+
+    CHECK(autotune_pick_sense(4, 40, 0) == 0); // threshold 22 is the base
+    CHECK(autotune_pick_sense(4, 40, 2) == -2);
+    CHECK(autotune_pick_sense(4, 100, 0) == -9);
+    CHECK(autotune_pick_sense(0, 2, 0) == 9);
+}
+
+int main()
+{
+    RUN(test_autotune_pick);
+    return test_failures ? 1 : 0;
+}
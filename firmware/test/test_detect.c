@@ -0,0 +1,58 @@
+/*
+ * Chu Pico Host Tests, touch detection
+ * WHowe <github.com/whowechina>
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "test.h"
+#include "config.h"
+#include "detect.h"
+
+static void test_detect()
+{
+    memset(&chu_cfg->sense, 0, sizeof(chu_cfg->sense));
+    chu_cfg->detect.on_level = 20;
+    chu_cfg->detect.off_level = 10;
+    chu_cfg->detect.noise_mult = 0;
+    chu_cfg->detect.tap_rise = 0;
+    chu_cfg->detect.tap_hold = 0;
+    detect_init();
+
+    CHECK(detect_threshold(3, true) == 20);
+    CHECK(detect_threshold(3, false) == 10);
+
+    detect_key(3, 490, 500, 0);
+    CHECK(!detect_touched(3));
+    detect_key(3, 475, 500, 1000);
+    CHECK(detect_touched(3));
+    CHECK(detect_delta(3) == 25);
+    detect_key(3, 488, 500, 2000); // above off level, hysteresis holds
+    CHECK(detect_touched(3));
+    detect_key(3, 492, 500, 3000);
+    CHECK(!detect_touched(3));
+
+    // sense config moves the threshold
+    chu_cfg->sense.keys[4] = 5;
+    CHECK(detect_threshold(4, true) == 15);
+
+    // a steep rise counts as a tap and is held for tap_hold
+    chu_cfg->detect.tap_rise = 8;
+    chu_cfg->detect.tap_hold = 5;
+    detect_init();
+    detect_key(5, 500, 500, 0);
+    detect_key(5, 488, 500, 1000);
+    CHECK(detect_touched(5));
+    detect_key(5, 500, 500, 2000);
+    CHECK(detect_touched(5));
+    detect_key(5, 500, 500, 6000);
+    CHECK(!detect_touched(5));
+}
+
+int main()
+{
+    RUN(test_detect);
+    return test_failures ? 1 : 0;
+}
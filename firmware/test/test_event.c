@@ -0,0 +1,132 @@
+/*
+ * Chu Pico Host Tests, input events
+ * WHowe <github.com/whowechina>
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "test.h"
+#include "event.h"
+
+#define RING_SIZE 64 // same as event.c
+#define STREAM_NUM 200000
+
+static void test_overflow()
+{
+    int ring = EVENT_RING_SLIDER;
+    uint32_t dropped = event_dropped(ring);
+    for (int i = 0; i < RING_SIZE; i++) {
+        CHECK(event_push(ring, i % EVENT_KEY_NUM, true, i));
+    }
+    CHECK(!event_push(ring, 0, true, 999));
+    CHECK(!event_push(ring, 0, true, 999));
+    CHECK(event_dropped(ring) == dropped + 2);
+
+    // full ring is intact, oldest first, the dropped ones never show up
+    event_t event;
+    for (int i = 0; i < RING_SIZE; i++) {
+        CHECK(event_pop(ring, &event));
+        CHECK(event.key == i % EVENT_KEY_NUM);
+        CHECK(event.time_us == i);
+    }
+    CHECK(!event_pop(ring, &event));
+}
+
+static void test_wrap()
+{
+    int ring = EVENT_RING_AIR;
+    event_t event;
+    uint32_t pushed = 0;
+    uint32_t popped = 0;
+    // ring stays partly filled while slots wrap around many times
+    for (int round = 0; round < RING_SIZE * 20; round++) {
+        for (int i = 0; i < 3; i++) {
+            CHECK(event_push(ring, EVENT_AIR_KEY + pushed % 6, pushed & 1,
+                             pushed));
+            pushed++;
+        }
+        for (int i = 0; i < 2; i++) {
+            CHECK(event_pop(ring, &event));
+            CHECK(event.time_us == popped);
+            CHECK(event.key == EVENT_AIR_KEY + popped % 6);
+            CHECK(event.pressed == (popped & 1));
+            popped++;
+        }
+        if (pushed - popped >= RING_SIZE - 3) {
+            while (event_pop(ring, &event)) {
+                CHECK(event.time_us == popped);
+                popped++;
+            }
+        }
+    }
+    while (event_pop(ring, &event)) {
+        CHECK(event.time_us == popped);
+        popped++;
+    }
+    CHECK(popped == pushed);
+    CHECK(event_dropped(ring) == 0);
+}
+
+static void *producer(void *arg)
+{
+    for (uint32_t i = 0; i < STREAM_NUM; i++) {
+        while (!event_push(EVENT_RING_SLIDER, i % 32, i & 1, i)) {
+            sched_yield(); // full, let the consumer run
+        }
+    }
+    return NULL;
+}
+
+// One producer thread and one consumer, like core 1 and core 0
+static void test_spsc_threads()
+{
+    uint32_t dropped = event_dropped(EVENT_RING_SLIDER);
+    pthread_t thread;
+    pthread_create(&thread, NULL, producer, NULL);
+
+    uint32_t expect = 0;
+    uint32_t wrong = 0;
+    event_t event;
+    while (expect < STREAM_NUM) {
+        if (!event_pop(EVENT_RING_SLIDER, &event)) {
+            sched_yield();
+            continue;
+        }
+        if ((event.time_us != expect) || (event.key != expect % 32) ||
+            (event.pressed != (expect & 1))) {
+            wrong++;
+        }
+        expect++;
+    }
+    pthread_join(thread, NULL);
+    CHECK(wrong == 0);
+    CHECK(!event_pop(EVENT_RING_SLIDER, &event));
+    // retried pushes were counted as drops, none got lost
+    CHECK(event_dropped(EVENT_RING_SLIDER) >= dropped);
+}
+
+static void test_history()
+{
+    event_clear_history();
+    for (uint32_t i = 0; i < 40; i++) {
+        event_t event = { .key = 1, .pressed = true, .time_us = i };
+        event_log(&event);
+    }
+    event_t events[8];
+    int num = event_history(events, 8);
+    CHECK(num == 8);
+    CHECK(events[0].time_us == 32);
+    CHECK(events[7].time_us == 39);
+}
+
+int main()
+{
+    RUN(test_overflow);
+    RUN(test_wrap);
+    RUN(test_spsc_threads);
+    RUN(test_history);
+    return test_failures ? 1 : 0;
+}
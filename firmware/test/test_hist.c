@@ -0,0 +1,30 @@
+/*
+ * Chu Pico Host Tests, touch histograms
+ * WHowe <github.com/whowechina>
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "test.h"
+#include "hist.h"
+
+static void test_hist_bucket()
+{
+    CHECK(hist_bucket(0) == 0);
+    CHECK(hist_bucket(511) == 0);
+    CHECK(hist_bucket(512) == 1);
+    CHECK(hist_bucket(1023) == 1);
+    CHECK(hist_bucket(1024) == 2);
+    CHECK(hist_bucket(UINT32_MAX) == HIST_BUCKETS - 1);
+    for (int b = 1; b < HIST_BUCKETS; b++) {
+        CHECK(hist_bucket(hist_bucket_floor(b)) == b);
+        CHECK(hist_bucket(hist_bucket_floor(b) - 1) == b - 1);
+    }
+}
+
+int main()
+{
+    RUN(test_hist_bucket);
+    return test_failures ? 1 : 0;
+}
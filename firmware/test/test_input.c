@@ -0,0 +1,135 @@
+/*
+ * Chu Pico Host Tests, input snapshot
+ * WHowe <github.com/whowechina>
+ * 
+ * Two writer threads play core 0 (slider) and core 1 (air) while readers
+ * check every snapshot is whole: each value is published together with a
+ * time derived from it, so a torn read shows up as a mismatch. A barrier
+ * hook also puts a write right after a read, which must be retried.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "test.h"
+#include "host.h"
+#include "input.h"
+
+#define ROUNDS 2000000
+#define READERS 2
+
+static atomic_bool writing;
+
+static void *touch_writer(void *arg)
+{
+    for (uint32_t i = 1; i <= ROUNDS; i++) {
+        input_publish_touch(i * 0x9e3779b9u, i);
+    }
+    return NULL;
+}
+
+static void *air_writer(void *arg)
+{
+    for (uint32_t i = 1; i <= ROUNDS; i++) {
+        input_publish_air(i & 0x3f, i);
+    }
+    return NULL;
+}
+
+static void *reader(void *arg)
+{
+    uint32_t *torn = arg;
+    uint32_t last_touch = 0;
+    uint32_t last_air = 0;
+    while (atomic_load(&writing)) {
+        input_t input;
+        input_read(&input);
+        if ((input.touch != input.touch_time_us * 0x9e3779b9u) ||
+            (input.air != (input.air_time_us & 0x3f)) ||
+            (input.touch_time_us < last_touch) ||
+            (input.air_time_us < last_air)) {
+            (*torn)++;
+        }
+        last_touch = input.touch_time_us;
+        last_air = input.air_time_us;
+    }
+    return NULL;
+}
+
+static void test_single_thread()
+{
+    input_t input;
+    input_publish_touch(0x12345678, 100);
+    input_publish_air(0x21, 200);
+    input_read(&input);
+    CHECK(input.touch == 0x12345678);
+    CHECK(input.touch_time_us == 100);
+    CHECK(input.air == 0x21);
+    CHECK(input.air_time_us == 200);
+
+    input_publish_touch(0, 300);
+    input_read(&input);
+    CHECK(input.touch == 0);
+    CHECK(input.air == 0x21); // other half untouched
+}
+
+static int barriers_left;
+
+static void write_mid_read()
+{
+    if (--barriers_left == 0) {
+        input_publish_touch(0xbeef, 2);
+    }
+}
+
+// A write landing while the reader copies must make it read again
+static void test_read_retry()
+{
+    input_publish_touch(0xdead, 1);
+    barriers_left = 2; // reader's second barrier, right after the copy
+    host_on_barrier(write_mid_read);
+    input_t input;
+    input_read(&input);
+    host_on_barrier(NULL);
+    CHECK(input.touch == 0xbeef);
+    CHECK(input.touch_time_us == 2);
+}
+
+static void test_no_torn_reads()
+{
+    pthread_t writers[2];
+    pthread_t readers[READERS];
+    uint32_t torn[READERS] = {0};
+
+    input_publish_touch(0, 0);
+    input_publish_air(0, 0);
+    atomic_store(&writing, true);
+    for (int i = 0; i < READERS; i++) {
+        pthread_create(&readers[i], NULL, reader, &torn[i]);
+    }
+    pthread_create(&writers[0], NULL, touch_writer, NULL);
+    pthread_create(&writers[1], NULL, air_writer, NULL);
+    pthread_join(writers[0], NULL);
+    pthread_join(writers[1], NULL);
+    atomic_store(&writing, false);
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(readers[i], NULL);
+        CHECK(torn[i] == 0);
+    }
+
+    input_t input;
+    input_read(&input);
+    CHECK(input.touch_time_us == ROUNDS);
+    CHECK(input.air_time_us == ROUNDS);
+}
+
+int main()
+{
+    input_init();
+    RUN(test_single_thread);
+    RUN(test_read_retry);
+    RUN(test_no_torn_reads);
+    return test_failures ? 1 : 0;
+}
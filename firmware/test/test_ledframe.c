@@ -0,0 +1,203 @@
+/*
+ * Chu Pico Host Tests, LED frame handoff
+ * WHowe <github.com/whowechina>
+ * 
+ * Host and idle writer threads fill whole frames with one value each, the
+ * driver thread checks every frame it picks up is a single value. Threads
+ * yield in the middle of filling and sending, so any overlap of a writer
+ * with the other writer or the driver shows up as a mixed frame.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "test.h"
+#include "ledframe.h"
+
+#define ROUNDS 20000
+#define IDLE_TAG 0x80000000
+
+static void fill(uint32_t value)
+{
+    uint32_t *back = ledframe_back();
+    for (int i = 0; i < LED_NUM; i++) {
+        back[i] = value;
+        if (i == LED_NUM / 2) {
+            sched_yield();
+        }
+    }
+}
+
+static void test_writers()
+{
+    CHECK(ledframe_begin(LEDFRAME_HOST));
+    CHECK(ledframe_begin(LEDFRAME_HOST)); // parts of a frame
+    CHECK(!ledframe_begin(LEDFRAME_IDLE));
+    ledframe_end();
+    CHECK(ledframe_begin(LEDFRAME_IDLE));
+    CHECK(!ledframe_begin(LEDFRAME_HOST));
+    ledframe_end();
+}
+
+static void test_present()
+{
+    uint32_t presented, dropped, torn, skipped;
+    ledframe_stat(&presented, &dropped, &torn, &skipped);
+
+    ledframe_begin(LEDFRAME_HOST);
+    fill(1);
+    ledframe_present(true);
+    CHECK(ledframe_pending());
+    CHECK(ledframe_back()[0] == 1); // next frame starts from this one
+    ledframe_back()[0] = 2;
+    ledframe_end();
+
+    const uint32_t *front = ledframe_front();
+    CHECK(!ledframe_pending());
+    CHECK(front[0] == 1);
+    CHECK(ledframe_front()[0] == 1); // nothing new, same frame again
+
+    ledframe_begin(LEDFRAME_HOST);
+    ledframe_present(false);
+    fill(3);
+    ledframe_present(true);
+    ledframe_end();
+    CHECK(ledframe_front()[0] == 3);
+
+    uint32_t p, d, t, s;
+    ledframe_stat(&p, &d, &t, &s);
+    CHECK(p == presented + 3);
+    CHECK(d == dropped + 1); // frame 2 was replaced before pickup
+    CHECK(t == torn + 1);
+}
+
+static uint32_t skipped()
+{
+    uint32_t presented, dropped, torn, skipped;
+    ledframe_stat(&presented, &dropped, &torn, &skipped);
+    return skipped;
+}
+
+static void test_seq()
+{
+    uint32_t base = skipped();
+    ledframe_seq(10);
+    ledframe_seq(11);
+    CHECK(skipped() == base);
+    ledframe_seq(14); // 12 and 13 lost
+    CHECK(skipped() == base + 2);
+    ledframe_seq(254);
+    ledframe_seq(255);
+    ledframe_seq(1); // wraps, 0 lost
+    CHECK(skipped() == base + 2 + 1);
+
+    // host not using it, or sending a frame again
+    base = skipped();
+    for (int i = 0; i < 10; i++) {
+        ledframe_seq(0);
+    }
+    ledframe_seq(0);
+    CHECK(skipped() == base);
+
+    // out of order or a big jump is a resync, not a loss
+    ledframe_seq(50);
+    ledframe_seq(49);
+    ledframe_seq(200);
+    CHECK(skipped() == base);
+    ledframe_seq(201);
+    CHECK(skipped() == base);
+}
+
+static atomic_bool running;
+
+static void *host_writer(void *arg)
+{
+    for (uint32_t n = 1; n <= ROUNDS; n++) {
+        while (!ledframe_begin(LEDFRAME_HOST)) {
+            sched_yield();
+        }
+        fill(n);
+        ledframe_present(true);
+        ledframe_end();
+    }
+    return NULL;
+}
+
+static void *idle_writer(void *arg)
+{
+    for (uint32_t n = 1; atomic_load(&running); n++) {
+        // like the light show, only when the driver took the last one
+        if (ledframe_pending() || !ledframe_begin(LEDFRAME_IDLE)) {
+            sched_yield();
+            continue;
+        }
+        fill(IDLE_TAG | n);
+        ledframe_present(true);
+        ledframe_end();
+        sched_yield();
+    }
+    return NULL;
+}
+
+static void *driver(void *arg)
+{
+    uint32_t *mixed = arg;
+    uint32_t last_host = 0;
+    uint32_t last_idle = 0;
+    while (atomic_load(&running)) {
+        const uint32_t *frame = ledframe_front();
+        uint32_t value = frame[0];
+        for (int i = 1; i < LED_NUM; i++) {
+            if (frame[i] != value) {
+                (*mixed)++;
+                break;
+            }
+            if (i == LED_NUM / 2) {
+                sched_yield();
+            }
+        }
+        // frames of each writer come out in order
+        uint32_t *last = (value & IDLE_TAG) ? &last_idle : &last_host;
+        if (value < *last) {
+            (*mixed)++;
+        }
+        *last = value;
+    }
+    return NULL;
+}
+
+static void test_handoff_threads()
+{
+    uint32_t mixed = 0;
+    pthread_t threads[3];
+
+    // start from frame 0, so host frames only go up from here
+    ledframe_begin(LEDFRAME_HOST);
+    fill(0);
+    ledframe_present(true);
+    ledframe_end();
+    ledframe_front();
+
+    atomic_store(&running, true);
+    pthread_create(&threads[0], NULL, driver, &mixed);
+    pthread_create(&threads[1], NULL, idle_writer, NULL);
+    pthread_create(&threads[2], NULL, host_writer, NULL);
+    pthread_join(threads[2], NULL);
+    atomic_store(&running, false);
+    pthread_join(threads[1], NULL);
+    pthread_join(threads[0], NULL);
+    CHECK(mixed == 0);
+}
+
+int main()
+{
+    ledframe_init();
+    RUN(test_writers);
+    RUN(test_present);
+    RUN(test_seq);
+    RUN(test_handoff_threads);
+    return test_failures ? 1 : 0;
+}
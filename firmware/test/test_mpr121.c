@@ -0,0 +1,406 @@
+/*
+ * Chu Pico Host Tests, MPR121 driver
+ * WHowe <github.com/whowechina>
+ * 
+ * mpr121.c as it is, on the I2C and DMA model of host/i2c.c.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "host.h"
+#include "test.h"
+#include "pico/time.h"
+#include "hardware/i2c.h"
+
+#include "board_defs.h"
+#include "mpr121.h"
+
+static const uint8_t addrs[3] = { MPR121_ADDR, MPR121_ADDR + 1, MPR121_ADDR + 2 };
+
+static bool wait_async()
+{
+    for (int i = 0; i < 100000; i++) {
+        if (!mpr121_async_busy()) {
+            return true;
+        }
+        host_i2c_tick();
+    }
+    return false;
+}
+
+static void set_status(int m, uint16_t status)
+{
+    uint8_t *regs = host_i2c_chip(addrs[m]);
+    regs[0] = status & 0xff;
+    regs[1] = status >> 8;
+}
+
+static void reset_bus()
+{
+    for (int m = 0; m < 3; m++) {
+        host_i2c_fault(addrs[m], HOST_I2C_OK);
+        set_status(m, 0);
+    }
+    mpr121_health_reset();
+    host_i2c_clear_ops();
+}
+
+static void test_async_order()
+{
+    reset_bus();
+    for (int m = 0; m < 3; m++) {
+        set_status(m, 0x0100 * m + 0x11 * (m + 1));
+    }
+
+    uint8_t buf[6] = {0};
+    uint64_t start = time_us_64();
+    CHECK(mpr121_read_async(addrs, 3, 0x00, buf, 2));
+    CHECK(!mpr121_read_async(addrs, 3, 0x00, buf, 2)); // busy
+    CHECK(mpr121_async_busy());
+    CHECK(wait_async());
+
+    CHECK(mpr121_async_failed() == 0);
+    for (int m = 0; m < 3; m++) {
+        CHECK(buf[m * 2] == 0x11 * (m + 1));
+        CHECK(buf[m * 2 + 1] == m);
+        CHECK(mpr121_health(addrs[m])->transfers == 1);
+        CHECK(mpr121_health(addrs[m])->errors == 0);
+    }
+
+    const host_i2c_op_t *ops;
+    CHECK(host_i2c_ops(&ops) == 3);
+    for (int m = 0; m < 3; m++) {
+        CHECK(ops[m].dma && ops[m].read);
+        CHECK(ops[m].addr == addrs[m]);
+        CHECK((ops[m].reg == 0x00) && (ops[m].len == 2));
+    }
+    // one after another, 5 bytes each at 400kHz
+    CHECK(ops[1].time_us > ops[0].time_us);
+    CHECK(ops[2].time_us > ops[1].time_us);
+    CHECK(time_us_64() - start < 3 * 150);
+
+    // chips in any order, buffer slots follow the order given
+    uint8_t two[2] = { addrs[2], addrs[0] };
+    host_i2c_clear_ops();
+    CHECK(mpr121_read_async(two, 2, 0x00, buf, 2));
+    CHECK(wait_async());
+    CHECK((buf[0] == 0x33) && (buf[1] == 2));
+    CHECK((buf[2] == 0x11) && (buf[3] == 0));
+    CHECK(host_i2c_ops(&ops) == 2);
+    CHECK((ops[0].addr == addrs[2]) && (ops[1].addr == addrs[0]));
+}
+
+static void test_async_nak()
+{
+    reset_bus();
+    set_status(0, 0x0001);
+    set_status(1, 0x0002);
+    set_status(2, 0x0004);
+    host_i2c_fault(addrs[1], HOST_I2C_NAK);
+
+    uint8_t buf[6];
+    memset(buf, 0xee, sizeof(buf));
+    uint64_t start = time_us_64();
+    CHECK(mpr121_read_async(addrs, 3, 0x00, buf, 2));
+    CHECK(wait_async());
+
+    CHECK(mpr121_async_failed() == 0x02);
+    CHECK(buf[0] == 0x01);
+    CHECK(buf[2] == 0xee); // left alone
+    CHECK(buf[4] == 0x04);
+    CHECK(mpr121_health(addrs[1])->errors == 1);
+    CHECK(mpr121_health(addrs[1])->timeouts == 0);
+    CHECK(mpr121_health(addrs[1])->fail_streak == 1);
+    CHECK(mpr121_health(addrs[2])->fail_streak == 0);
+
+    // the chip after the failed one only goes once its deadline passed
+    const host_i2c_op_t *ops;
+    CHECK(host_i2c_ops(&ops) == 3);
+    CHECK(ops[2].addr == addrs[2]);
+    CHECK(ops[2].time_us - ops[1].time_us > 2000);
+    CHECK(time_us_64() - start < 2500);
+}
+
+static void test_async_hang()
+{
+    reset_bus();
+    set_status(1, 0x0020);
+    host_i2c_fault(addrs[0], HOST_I2C_HANG);
+
+    uint8_t buf[6] = {0};
+    CHECK(mpr121_read_async(addrs, 3, 0x00, buf, 2));
+    CHECK(wait_async());
+    CHECK(mpr121_async_failed() == 0x01);
+    CHECK(buf[2] == 0x20);
+    CHECK(mpr121_health(addrs[0])->timeouts == 1);
+    CHECK(mpr121_health(addrs[0])->errors == 0);
+
+    // recovered chip reads fine again, failures are per read
+    host_i2c_fault(addrs[0], HOST_I2C_OK);
+    set_status(0, 0x0003);
+    CHECK(mpr121_read_async(addrs, 1, 0x00, buf, 2));
+    CHECK(wait_async());
+    CHECK(mpr121_async_failed() == 0);
+    CHECK(buf[0] == 0x03);
+    CHECK(mpr121_health(addrs[0])->fail_streak == 0);
+}
+
+static void test_async_then_blocking()
+{
+    reset_bus();
+    set_status(2, 0x0808);
+
+    uint8_t buf[6];
+    CHECK(mpr121_read_async(addrs, 3, 0x00, buf, 2));
+    CHECK(mpr121_touched(addrs[2]) == 0x0808); // waits for the DMA reads
+    CHECK(!mpr121_async_busy());
+
+    const host_i2c_op_t *ops;
+    CHECK(host_i2c_ops(&ops) == 4);
+    CHECK(ops[2].dma);
+    CHECK(!ops[3].dma && ops[3].read && (ops[3].addr == addrs[2]));
+}
+
+static void test_async_limits()
+{
+    reset_bus();
+    uint8_t buf[5 * 48];
+    uint8_t five[5] = { 0x5a, 0x5b, 0x5c, 0x5a, 0x5b };
+    CHECK(!mpr121_read_async(five, 5, 0x00, buf, 2));
+    CHECK(!mpr121_read_async(addrs, 3, 0x00, buf, 0));
+    CHECK(!mpr121_read_async(addrs, 3, 0x00, buf, 49));
+    CHECK(!mpr121_async_busy());
+}
+
+// Writes other than ECR and baselines, those come with every commit
+static int config_writes(const host_i2c_op_t **found)
+{
+    static host_i2c_op_t writes[16];
+    const host_i2c_op_t *ops;
+    int num = 0;
+    for (int i = 0, n = host_i2c_ops(&ops); (i < n) && (num < 16); i++) {
+        if (!ops[i].read && (ops[i].reg != 0x5E) && (ops[i].reg != 0x1E)) {
+            writes[num++] = ops[i];
+        }
+    }
+    *found = writes;
+    return num;
+}
+
+static void test_init_image()
+{
+    uint8_t addr = MPR121_ADDR + 3;
+    uint8_t *regs = host_i2c_chip(addr);
+    host_i2c_clear_ops();
+    mpr121_init(addr);
+
+    // soft reset, then each managed range in one transfer while stopped
+    const host_i2c_op_t *ops;
+    CHECK(host_i2c_ops(&ops) == 6);
+    CHECK((ops[0].reg == 0x80) && (ops[0].data[0] == 0x63));
+    CHECK((ops[1].reg == 0x5E) && ((ops[1].data[0] & 0x3f) == 0));
+    CHECK((ops[2].reg == 0x2B) && (ops[2].len == 0x35 - 0x2B + 1));
+    CHECK((ops[3].reg == 0x41) && (ops[3].len == 0x5D - 0x41 + 1));
+    CHECK((ops[4].reg == 0x7B) && (ops[4].len == 0x7F - 0x7B + 1));
+    CHECK((ops[5].reg == 0x5E) && (ops[5].data[0] == 0x8C));
+    CHECK(host_i2c_ignored(addr) == 0);
+
+    CHECK(regs[0x2B] == 1);
+    CHECK(regs[0x31] == 6);
+    CHECK(regs[0x35] == 30);
+    for (int i = 0; i < 12; i++) {
+        CHECK(regs[0x41 + i * 2] == MPR121_TOUCH_THRESHOLD_BASE);
+        CHECK(regs[0x42 + i * 2] == 15);
+    }
+    CHECK(regs[0x5C] == 0x10);
+    CHECK(regs[0x5D] == 0x28);
+    CHECK(regs[0x7B] == 0x0B);
+    CHECK(regs[0x7D] == 248);
+    CHECK(regs[0x5E] == 0x8C);
+    CHECK(host_i2c_autoconfigs(addr) == 1);
+}
+
+static void test_dirty_ranges()
+{
+    reset_bus();
+    uint8_t addr = addrs[0];
+    uint8_t *regs = host_i2c_chip(addr);
+
+    // first commit once running turns autoconfig off on the wire
+    mpr121_commit(addr);
+    CHECK((regs[0x7B] & 0x03) == 0);
+
+    // nothing staged, nothing on the wire
+    host_i2c_clear_ops();
+    CHECK(mpr121_commit(addr) == 0);
+    const host_i2c_op_t *ops;
+    CHECK(host_i2c_ops(&ops) == 0);
+
+    // only the bytes that differ, key 3 is touch and release at 0x47
+    int8_t keys[12] = {0};
+    keys[3] = 4;
+    mpr121_sense(addr, 0, keys, 12);
+    CHECK(mpr121_commit(addr) > 0);
+    const host_i2c_op_t *writes;
+    CHECK(config_writes(&writes) == 1);
+    CHECK((writes[0].reg == 0x47) && (writes[0].len == 2));
+    CHECK(regs[0x47] == MPR121_TOUCH_THRESHOLD_BASE - 4);
+    CHECK(regs[0x48] == 15 - 2);
+    CHECK(host_i2c_ignored(addr) == 0);
+
+    // debounce and filter in one range, filter also in autoconfig range
+    host_i2c_clear_ops();
+    mpr121_debounce(addr, 2, 3);
+    mpr121_filter(addr, 1, 2, 4);
+    CHECK(mpr121_commit(addr) > 0);
+    CHECK(config_writes(&writes) == 2);
+    CHECK((writes[0].reg == 0x5B) && (writes[0].len == 3));
+    CHECK((writes[1].reg == 0x7B) && (writes[1].len == 1));
+    CHECK(regs[0x5B] == 0x32);
+    CHECK(regs[0x5C] == 0x50);
+    CHECK(regs[0x5D] == 0x34);
+    CHECK((regs[0x7B] & 0xc0) == 0x40);
+
+    // first and last key changed, one transfer spans them, release
+    // thresholds move by half so key 0 and 11 only change at 0x41, 0x57
+    host_i2c_clear_ops();
+    keys[3] = 0;
+    keys[0] = 1;
+    keys[11] = 1;
+    mpr121_sense(addr, 0, keys, 12);
+    CHECK(mpr121_commit(addr) > 0);
+    CHECK(config_writes(&writes) == 1);
+    CHECK((writes[0].reg == 0x41) && (writes[0].len == 0x57 - 0x41 + 1));
+    CHECK(regs[0x47] == MPR121_TOUCH_THRESHOLD_BASE);
+
+    // a failed write stays staged and goes with the next commit
+    host_i2c_clear_ops();
+    memset(keys, 0, sizeof(keys));
+    mpr121_sense(addr, 0, keys, 12);
+    host_i2c_fault(addr, HOST_I2C_NAK);
+    mpr121_commit(addr);
+    CHECK(regs[0x41] == MPR121_TOUCH_THRESHOLD_BASE - 1);
+    host_i2c_fault(addr, HOST_I2C_OK);
+    host_i2c_clear_ops();
+    CHECK(mpr121_commit(addr) > 0);
+    CHECK(config_writes(&writes) == 1);
+    CHECK(regs[0x41] == MPR121_TOUCH_THRESHOLD_BASE);
+    CHECK(regs[0x57] == MPR121_TOUCH_THRESHOLD_BASE);
+
+    mpr121_debounce(addr, 0, 0);
+    mpr121_filter(addr, 0, 1, 0);
+    mpr121_commit(addr);
+}
+
+// Tracked baselines away from what a reload from filtered data would give
+static void set_tracking(uint8_t *regs)
+{
+    for (int i = 0; i < 13; i++) {
+        regs[0x04 + i * 2] = 600 & 0xff;
+        regs[0x05 + i * 2] = 600 >> 8;
+        regs[0x1E + i] = 100 + i;
+    }
+}
+
+static void test_commit_baselines()
+{
+    reset_bus();
+    uint8_t addr = addrs[1];
+    uint8_t *regs = host_i2c_chip(addr);
+    mpr121_commit(addr);
+    set_tracking(regs);
+    uint32_t autoconfigs = host_i2c_autoconfigs(addr);
+
+    int8_t keys[12] = {0};
+    mpr121_sense(addr, 3, keys, 12);
+    host_i2c_clear_ops();
+    uint64_t start = time_us_64();
+    uint32_t offline = mpr121_commit(addr);
+
+    // one window: stop, save, config, restore, resume
+    const host_i2c_op_t *ops;
+    CHECK(host_i2c_ops(&ops) == 5);
+    CHECK(!ops[0].read && (ops[0].reg == 0x5E) && (ops[0].data[0] == 0x80));
+    CHECK(ops[1].read && (ops[1].reg == 0x1E) && (ops[1].len == 13));
+    CHECK(!ops[2].read && (ops[2].reg == 0x41));
+    CHECK(!ops[3].read && (ops[3].reg == 0x1E) && (ops[3].len == 13));
+    for (int i = 0; i < 13; i++) {
+        CHECK(ops[3].data[i] == 100 + i);
+    }
+    CHECK(!ops[4].read && (ops[4].reg == 0x5E));
+    CHECK(host_i2c_ignored(addr) == 0);
+
+    // resumed with CL=00, tracking goes on from the saved baselines
+    CHECK(regs[0x5E] == 0x0C);
+    for (int i = 0; i < 13; i++) {
+        CHECK(regs[0x1E + i] == 100 + i);
+    }
+    CHECK(regs[0x41] == MPR121_TOUCH_THRESHOLD_BASE - 3);
+    CHECK(host_i2c_autoconfigs(addr) == autoconfigs);
+
+    // offline from the stop to the end of resume, a few transfers at 400kHz
+    CHECK(offline == time_us_64() - start);
+    CHECK((offline > 0) && (offline < 2000));
+    CHECK(ops[0].time_us >= start);
+
+    mpr121_sense(addr, 0, keys, 12);
+    mpr121_commit(addr);
+}
+
+static void test_commit_after_autoconfig()
+{
+    reset_bus();
+    uint8_t addr = addrs[2];
+    uint8_t *regs = host_i2c_chip(addr);
+    mpr121_commit(addr);
+    set_tracking(regs);
+
+    // rerun reloads baselines from data, like at power up
+    uint32_t autoconfigs = host_i2c_autoconfigs(addr);
+    mpr121_autoconfig(addr);
+    CHECK(host_i2c_autoconfigs(addr) == autoconfigs + 1);
+    CHECK(mpr121_health(addr)->autoconfigs == 1);
+    CHECK(regs[0x1E] == (150 & 0xf8));
+    CHECK(regs[0x5E] == 0x8C);
+    CHECK((regs[0x7B] & 0x03) == 0x03);
+
+    // a config change later must not rerun it or reload baselines
+    set_tracking(regs);
+    mpr121_debounce(addr, 1, 1);
+    CHECK(mpr121_commit(addr) > 0);
+    CHECK(host_i2c_autoconfigs(addr) == autoconfigs + 1);
+    CHECK((regs[0x7B] & 0x03) == 0);
+    CHECK(regs[0x5E] == 0x0C);
+    for (int i = 0; i < 13; i++) {
+        CHECK(regs[0x1E + i] == 100 + i);
+    }
+
+    mpr121_debounce(addr, 0, 0);
+    mpr121_commit(addr);
+}
+
+int main()
+{
+    for (int m = 0; m < 3; m++) {
+        host_i2c_chip(addrs[m]);
+    }
+    host_on_spin(host_i2c_tick);
+    i2c_init(I2C_PORT, 400 * 1000);
+    for (int m = 0; m < 3; m++) {
+        mpr121_init(addrs[m]);
+    }
+    mpr121_async_init();
+
+    RUN(test_async_order);
+    RUN(test_async_nak);
+    RUN(test_async_hang);
+    RUN(test_async_then_blocking);
+    RUN(test_async_limits);
+    RUN(test_init_image);
+    RUN(test_dirty_ranges);
+    RUN(test_commit_baselines);
+    RUN(test_commit_after_autoconfig);
+    return test_failures ? 1 : 0;
+}
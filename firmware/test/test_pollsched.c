@@ -0,0 +1,181 @@
+/*
+ * Chu Pico Host Tests, slider poll scheduling
+ * WHowe <github.com/whowechina>
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "test.h"
+
+#include "pollsched.h"
+
+static void test_sched_period()
+{
+    for (int esi = 0; esi < 8; esi++) {
+        pollsched_config(0x20 | esi);
+        uint32_t period, polls, fresh;
+        pollsched_rates(&period, &polls, &fresh);
+        CHECK(period == 1000u << esi);
+        CHECK(pollsched_due(0)); // config change reads right away
+    }
+}
+
+typedef struct {
+    int polls;
+    int fresh;
+    int missed;
+    double latency_max;
+    uint32_t poll_rate;
+    uint32_t fresh_rate;
+} sched_run_t;
+
+/* Slider loop every 50us on a chip sampling every period * (1 + drift),
+ * a read takes read_us and sees the data as of its middle. Counted after
+ * a second to settle, for 4 seconds. */
+static sched_run_t sched_run(uint8_t filter, double drift, uint32_t read_us)
+{
+    sched_run_t run = {0};
+    pollsched_config(filter);
+    uint32_t period, polls, fresh;
+    pollsched_rates(&period, &polls, &fresh);
+    double chip_period = period * (1 + drift);
+    const double phase = 777;
+
+    uint64_t start = 10000000;
+    int64_t last = -1;
+    for (uint64_t now = start; now < start + 5000000; ) {
+        if (!pollsched_due(now)) {
+            now += 50;
+            continue;
+        }
+        double seen = now + read_us / 2;
+        int64_t sample = (seen - phase) / chip_period;
+        bool is_fresh = (sample != last);
+        if (now >= start + 1000000) {
+            run.polls++;
+            if (is_fresh) {
+                run.fresh++;
+                run.missed += sample - last - 1;
+                double latency = seen - (phase + sample * chip_period);
+                if (latency > run.latency_max) {
+                    run.latency_max = latency;
+                }
+            }
+        }
+        last = sample;
+        pollsched_done(now, is_fresh);
+        now += read_us;
+    }
+    pollsched_rates(&period, &run.poll_rate, &run.fresh_rate);
+    return run;
+}
+
+/* No sample missed, each seen within 1/8 period or one read after it,
+ * whichever is longer, and seldom more than one poll per sample. */
+static void check_run(sched_run_t run, uint32_t period, uint32_t read_us,
+                      double polls_per_sample)
+{
+    uint32_t late = (read_us > period / 8) ? read_us : period / 8;
+    CHECK(run.missed == 0);
+    CHECK(run.latency_max <= late + 50);
+    CHECK(run.polls <= run.fresh * polls_per_sample);
+}
+
+static void test_sched_follows_samples()
+{
+    // 4ms ESI, 3 chips up to baselines take about 1.2ms at 1MHz
+    sched_run_t run = sched_run(0x22, 0, 1200);
+    check_run(run, 4000, 1200, 1.5);
+    CHECK(run.fresh >= 999 && run.fresh <= 1001);
+    CHECK(run.fresh_rate >= 249 && run.fresh_rate <= 251);
+    CHECK(run.poll_rate <= run.fresh_rate * 3 / 2);
+
+    // fast sampling, reads take most of the period
+    check_run(sched_run(0x20, 0, 600), 1000, 600, 1.5);
+
+    // slow sampling, most polls would find nothing new
+    check_run(sched_run(0x25, 0, 1200), 32000, 1200, 1.6);
+}
+
+static void test_sched_chip_clock()
+{
+    // MPR121 clock off by a few percent either way
+    check_run(sched_run(0x23, 0.04, 1200), 8000, 1200, 1.75);
+    check_run(sched_run(0x23, -0.04, 1200), 8000, 1200, 1.75);
+}
+
+static void test_chips_detect()
+{
+    // firmware detection needs data of every chip every time
+    for (uint64_t now = 1000000; now < 1001000; now += 100) {
+        CHECK(pollsched_chips(now, true, 0) == 0x07);
+    }
+}
+
+/* IRQ lines of a slider loop running every 100us for a second, chip 1
+ * asserts 10 times, its IRQ clears once read. */
+static void test_chips_irq()
+{
+    uint64_t start = 2000000;
+    uint32_t reads[3] = {0};
+    int polls_all = 0;
+    uint8_t asserted = 0;
+    uint64_t asserted_at = 0;
+    uint32_t latency_max = 0;
+    uint64_t last_all = start;
+
+    for (uint64_t now = start; now < start + 1000000; now += 100) {
+        if ((now - start) % 100000 == 33300) {
+            asserted |= 0x02;
+            asserted_at = now;
+        }
+        uint8_t chips = pollsched_chips(now, false, asserted);
+        if (chips == 0x07) {
+            polls_all++;
+            CHECK(now - last_all <= 20000);
+            last_all = now;
+        }
+        for (int m = 0; m < 3; m++) {
+            if (chips & (1 << m)) {
+                reads[m]++;
+            }
+        }
+        if (chips & asserted & 0x02) {
+            if (now - asserted_at > latency_max) {
+                latency_max = now - asserted_at;
+            }
+            asserted = 0;
+        }
+    }
+
+    CHECK(polls_all >= 49 && polls_all <= 51);
+    CHECK(reads[0] == polls_all);
+    CHECK(reads[2] == polls_all);
+    CHECK(reads[1] == polls_all + 10);
+    CHECK(latency_max == 0); // read in the same loop it asserted
+    CHECK(reads[0] < 10000 / 100); // vs 10000 when polling every loop
+}
+
+static void test_chips_stuck_low()
+{
+    // an edge missed or a line held low keeps its chip read every time
+    uint64_t now = 3000000;
+    pollsched_chips(now, true, 0);
+    for (int i = 1; i < 50; i++) {
+        CHECK(pollsched_chips(now + i * 100, false, 0x04) == 0x04);
+    }
+    CHECK(pollsched_chips(now + 20000, false, 0x04) == 0x07);
+    CHECK(pollsched_chips(now + 20100, false, 0xf8) == 0); // no such chips
+}
+
+int main()
+{
+    RUN(test_sched_period);
+    RUN(test_sched_follows_samples);
+    RUN(test_sched_chip_clock);
+    RUN(test_chips_detect);
+    RUN(test_chips_irq);
+    RUN(test_chips_stuck_low);
+    return test_failures ? 1 : 0;
+}
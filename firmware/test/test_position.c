@@ -0,0 +1,39 @@
+/*
+ * Chu Pico Host Tests, slider position
+ * WHowe <github.com/whowechina>
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "test.h"
+#include "position.h"
+
+static void test_position()
+{
+    int16_t delta[32] = {0};
+    uint16_t pos[POSITION_MAX];
+
+    CHECK(position_compute(delta, 0, pos, POSITION_MAX) == 0);
+
+    delta[10] = 30; // column 5
+    CHECK(position_compute(delta, 1UL << 10, pos, POSITION_MAX) == 1);
+    CHECK(pos[0] == 5 * POSITION_SCALE);
+
+    delta[12] = 30; // column 6 as well, finger in between
+    uint32_t touched = (1UL << 10) | (1UL << 12);
+    CHECK(position_compute(delta, touched, pos, POSITION_MAX) == 1);
+    CHECK(pos[0] == 5 * POSITION_SCALE + POSITION_SCALE / 2);
+
+    delta[30] = 40; // column 15, a second finger
+    touched |= 1UL << 31;
+    CHECK(position_compute(delta, touched, pos, POSITION_MAX) == 2);
+    CHECK(pos[1] == 15 * POSITION_SCALE);
+    CHECK(position_compute(delta, touched, pos, 1) == 1);
+}
+
+int main()
+{
+    RUN(test_position);
+    return test_failures ? 1 : 0;
+}
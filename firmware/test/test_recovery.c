@@ -0,0 +1,346 @@
+/*
+ * Chu Pico Host Tests, slider recovery
+ * WHowe <github.com/whowechina>
+ * 
+ * recovery.c with mpr121.c on the I2C model of host/i2c.c, faults are
+ * injected on the bus.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "host.h"
+#include "test.h"
+#include "pico/time.h"
+#include "hardware/i2c.h"
+
+#include "board_defs.h"
+#include "mpr121.h"
+#include "recovery.h"
+
+static const uint8_t addrs[3] = { MPR121_ADDR, MPR121_ADDR + 1, MPR121_ADDR + 2 };
+
+static void fail_reads(int m, int num)
+{
+    for (int i = 0; i < num; i++) {
+        mpr121_touched(addrs[m]);
+    }
+}
+
+static void test_health_ok()
+{
+    host_set_time(1000000);
+    host_i2c_clear_ops();
+    CHECK(recovery_health(400000) == 0);
+    const host_i2c_op_t *ops;
+    CHECK(host_i2c_ops(&ops) == 0);
+
+    // a few failures don't count, the streak breaks on success
+    host_i2c_fault(addrs[0], HOST_I2C_NAK);
+    fail_reads(0, 7);
+    host_i2c_fault(addrs[0], HOST_I2C_OK);
+    CHECK(recovery_health(400000) == 0);
+    fail_reads(0, 1);
+    CHECK(mpr121_health(addrs[0])->fail_streak == 0);
+}
+
+/* Slider loop every ms: the chip is polled, then checked for recovery. A
+ * re-init resets the streak, polls failing again build it back up. */
+static uint8_t slider_loop(int m)
+{
+    host_set_time(time_us_64() + 1000);
+    mpr121_touched(addrs[m]);
+    return recovery_health(400000);
+}
+
+/* A chip stays broken for 10 seconds, retries back off from 10ms doubling
+ * up to 1s. */
+static void test_health_backoff()
+{
+    uint64_t start = 2000000;
+    host_set_time(start);
+    host_i2c_fault(addrs[1], HOST_I2C_NAK);
+    fail_reads(1, 8);
+    uint32_t recoveries = mpr121_health(addrs[1])->recoveries;
+
+    uint64_t tries[32];
+    int num = 0;
+    while (time_us_64() < start + 10000000) {
+        uint8_t recovered = slider_loop(1);
+        if (recovered) {
+            CHECK(recovered == 0x02);
+            if (num < 32) {
+                tries[num++] = time_us_64();
+            }
+        }
+    }
+
+    CHECK(mpr121_health(addrs[1])->recoveries == recoveries + num);
+    CHECK(num == 14); // right away, 7 from 10 to 640ms, then 1.28s ones
+    for (int i = 1; i < num; i++) {
+        uint64_t gap = tries[i] - tries[i - 1];
+        uint64_t backoff = 10000 << (i - 1);
+        if (backoff > 1024000) {
+            backoff = 1280000; // doubled past 1s once, then held
+        }
+        CHECK((gap >= backoff) && (gap < backoff + 2000));
+    }
+
+    // healthy chips are left alone while another one is broken
+    CHECK(mpr121_health(addrs[0])->recoveries == 0);
+    CHECK(mpr121_health(addrs[2])->recoveries == 0);
+
+    // fixed, polls go through again, nothing more to recover
+    host_i2c_fault(addrs[1], HOST_I2C_OK);
+    int recovered = 0;
+    for (int i = 0; i < 2000; i++) {
+        recovered += slider_loop(1) ? 1 : 0;
+    }
+    CHECK(recovered == 0);
+    CHECK(mpr121_health(addrs[1])->fail_streak == 0);
+
+    // the backoff started over, a hung chip is retried 10ms after its
+    // init gave up, which took 27ms of timeouts
+    host_i2c_fault(addrs[1], HOST_I2C_HANG);
+    uint32_t errors = mpr121_health(addrs[1])->errors;
+    uint64_t first = 0;
+    uint64_t second = 0;
+    for (int i = 0; (i < 1000) && !second; i++) {
+        if (slider_loop(1)) {
+            if (!first) {
+                first = time_us_64();
+            } else {
+                second = time_us_64();
+            }
+        }
+    }
+    CHECK(second - first >= 10000 + 27000);
+    CHECK(second - first < 10000 + 27000 + 5000);
+    CHECK(mpr121_health(addrs[1])->timeouts > 0);
+    CHECK(mpr121_health(addrs[1])->errors == errors);
+    host_i2c_fault(addrs[1], HOST_I2C_OK);
+}
+
+static void test_health_bus_speed()
+{
+    // recovery brings the bus back at the speed in use
+    host_set_time(20000000);
+    host_i2c_fault(addrs[2], HOST_I2C_NAK);
+    fail_reads(2, 8);
+    CHECK(recovery_health(1000000) == 0x04);
+    CHECK(host_i2c_baudrate() == 1000000);
+    host_i2c_fault(addrs[2], HOST_I2C_OK);
+}
+
+static const uint32_t speeds[] = I2C_SPEEDS;
+
+static int selftest_reads()
+{
+    int reads = 0;
+    const host_i2c_op_t *ops;
+    for (int i = 0, n = host_i2c_ops(&ops); i < n; i++) {
+        if (ops[i].read && (ops[i].reg == 0x41)) {
+            reads++;
+        }
+    }
+    return reads;
+}
+
+static void set_limits(uint32_t max_rate, int one_in)
+{
+    for (int m = 0; m < 3; m++) {
+        host_i2c_limit(addrs[m], max_rate, one_in);
+    }
+}
+
+static void test_speed_clean()
+{
+    // the hung chip above never got its config, start over
+    for (int m = 0; m < 3; m++) {
+        host_i2c_fault(addrs[m], HOST_I2C_OK);
+        mpr121_init(addrs[m]);
+    }
+    set_limits(UINT32_MAX, 1);
+    host_i2c_clear_ops();
+    CHECK(recovery_speed(speeds, 2) == 2);
+    CHECK(host_i2c_baudrate() == speeds[2]);
+    CHECK(selftest_reads() == 3 * 16);
+
+    // slowest needs no test, the chips were set up at it
+    host_i2c_clear_ops();
+    CHECK(recovery_speed(speeds, 0) == 0);
+    CHECK(host_i2c_baudrate() == speeds[0]);
+    CHECK(selftest_reads() == 0);
+}
+
+static void test_speed_fallback()
+{
+    // one chip can't do 1MHz at all
+    set_limits(UINT32_MAX, 1);
+    host_i2c_limit(addrs[1], speeds[1], 1);
+    CHECK(recovery_speed(speeds, 2) == 1);
+    CHECK(host_i2c_baudrate() == speeds[1]);
+
+    // 2 bad reads in 16 rounds is over tolerance, all the way down
+    set_limits(UINT32_MAX, 1);
+    host_i2c_limit(addrs[2], speeds[0], 8);
+    host_i2c_clear_ops();
+    CHECK(recovery_speed(speeds, 2) == 0);
+    CHECK(host_i2c_baudrate() == speeds[0]);
+    CHECK(selftest_reads() == 2 * 3 * 16);
+
+    // 1 bad read is within tolerance
+    set_limits(UINT32_MAX, 1);
+    host_i2c_limit(addrs[0], speeds[1], 16);
+    CHECK(recovery_speed(speeds, 2) == 2);
+    CHECK(host_i2c_baudrate() == speeds[2]);
+
+    // errors spread over chips add up
+    set_limits(speeds[1], 16);
+    CHECK(recovery_speed(speeds, 2) == 1);
+    CHECK(host_i2c_baudrate() == speeds[1]);
+
+    set_limits(UINT32_MAX, 1);
+    recovery_speed(speeds, 0);
+}
+
+static void set_oor(int m, uint16_t oor)
+{
+    uint8_t *regs = host_i2c_chip(addrs[m]);
+    regs[0x02] = oor & 0xff;
+    regs[0x03] = oor >> 8;
+}
+
+static uint16_t get_oor(int m)
+{
+    uint8_t *regs = host_i2c_chip(addrs[m]);
+    return regs[0x02] | (regs[0x03] << 8);
+}
+
+// Slider loop every 100ms, counts reruns of each chip, returns time of last
+static uint64_t range_run(uint32_t ms, int reruns[3])
+{
+    uint64_t last = 0;
+    for (uint32_t t = 0; t < ms; t += 100) {
+        host_set_time(time_us_64() + 100000);
+        uint8_t rerun = recovery_range();
+        for (int m = 0; m < 3; m++) {
+            if (rerun & (1 << m)) {
+                reruns[m]++;
+                last = time_us_64();
+            }
+        }
+    }
+    return last;
+}
+
+static void test_range_poll()
+{
+    host_set_time(30000000);
+    for (int m = 0; m < 3; m++) {
+        set_oor(m, 0);
+    }
+    host_i2c_clear_ops();
+    int reruns[3] = {0};
+    range_run(3000, reruns);
+    CHECK(reruns[0] + reruns[1] + reruns[2] == 0);
+
+    // status of each chip once a second
+    const host_i2c_op_t *ops;
+    int num = host_i2c_ops(&ops);
+    CHECK(num == 3 * 3);
+    for (int i = 0; i < num; i++) {
+        CHECK(ops[i].read && (ops[i].reg == 0x02) && (ops[i].len == 2));
+    }
+}
+
+static void test_range_rerun()
+{
+    uint32_t autoconfigs = host_i2c_autoconfigs(addrs[1]);
+    uint32_t count = mpr121_health(addrs[1])->autoconfigs;
+    set_oor(1, 0x0008);
+    int reruns[3] = {0};
+    range_run(1000, reruns);
+    CHECK((reruns[0] == 0) && (reruns[1] == 1) && (reruns[2] == 0));
+    CHECK(host_i2c_autoconfigs(addrs[1]) == autoconfigs + 1);
+    CHECK(mpr121_health(addrs[1])->autoconfigs == count + 1);
+    CHECK(mpr121_health(addrs[1])->last_oor == 0x0008);
+    CHECK(get_oor(1) == 0);
+    CHECK(host_i2c_chip(addrs[1])[0x5E] == 0x8C); // running again
+
+    range_run(10000, reruns);
+    CHECK(reruns[1] == 1);
+
+    // not connected electrodes of the last chip don't count
+    set_oor(2, 0x0f00);
+    range_run(10000, reruns);
+    CHECK(reruns[2] == 0);
+    set_oor(2, 0);
+}
+
+static void test_range_broken()
+{
+    // a damaged electrode gets one rerun, then it's left alone
+    host_i2c_broken(addrs[0], 0x0020);
+    set_oor(0, 0x0020);
+    int reruns[3] = {0};
+    range_run(1000, reruns);
+    CHECK(reruns[0] == 1);
+    CHECK(get_oor(0) == 0x0020);
+    range_run(20000, reruns);
+    CHECK(reruns[0] == 1);
+
+    // others on the chip still get theirs
+    set_oor(0, 0x0024);
+    range_run(2000, reruns);
+    CHECK(reruns[0] == 2);
+    CHECK(get_oor(0) == 0x0020);
+    range_run(20000, reruns);
+    CHECK(reruns[0] == 2);
+
+    // repaired, back in range, it may be rerun for again
+    host_i2c_broken(addrs[0], 0);
+    set_oor(0, 0);
+    range_run(2000, reruns);
+    set_oor(0, 0x0020);
+    range_run(2000, reruns);
+    CHECK(reruns[0] == 3);
+    CHECK(get_oor(0) == 0);
+}
+
+static void test_range_retry()
+{
+    // another electrode right after a rerun waits for the retry interval
+    int reruns[3] = {0};
+    set_oor(1, 0x0001);
+    uint64_t first = range_run(1000, reruns);
+    CHECK(reruns[1] == 1);
+    range_run(1000, reruns);
+    set_oor(1, 0x0002);
+    uint64_t second = range_run(8000, reruns);
+    CHECK(reruns[1] == 2);
+    CHECK(second - first >= 5000000);
+    CHECK(second - first < 5000000 + 1100000);
+}
+
+int main()
+{
+    for (int m = 0; m < 3; m++) {
+        host_i2c_chip(addrs[m]);
+    }
+    i2c_init(I2C_PORT, 400 * 1000);
+    for (int m = 0; m < 3; m++) {
+        mpr121_init(addrs[m]);
+    }
+
+    RUN(test_health_ok);
+    RUN(test_health_backoff);
+    RUN(test_health_bus_speed);
+    RUN(test_speed_clean);
+    RUN(test_speed_fallback);
+    RUN(test_range_poll);
+    RUN(test_range_rerun);
+    RUN(test_range_broken);
+    RUN(test_range_retry);
+    return test_failures ? 1 : 0;
+}
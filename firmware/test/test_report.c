@@ -0,0 +1,32 @@
+/*
+ * Chu Pico Host Tests, report policy
+ * WHowe <github.com/whowechina>
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "test.h"
+#include "report.h"
+
+static void test_report_due()
+{
+    report_reset_stat();
+    CHECK(report_due(true, 1000));
+    CHECK(!report_due(false, 2000));
+    CHECK(!report_due(false, 50999));
+    CHECK(report_due(false, 51000)); // keepalive
+    CHECK(report_due(true, 51001)); // changes never wait
+    CHECK(!report_due(false, 60000));
+
+    uint32_t sent, suppressed;
+    report_stat(&sent, &suppressed);
+    CHECK(sent == 3);
+    CHECK(suppressed == 3);
+}
+
+int main()
+{
+    RUN(test_report_due);
+    return test_failures ? 1 : 0;
+}
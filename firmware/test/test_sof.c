@@ -0,0 +1,71 @@
+/*
+ * Chu Pico Host Tests, frame sync
+ * WHowe <github.com/whowechina>
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "test.h"
+#include "host.h"
+#include "hardware/irq.h"
+#include "hardware/structs/usb.h"
+
+#include "config.h"
+#include "sof.h"
+
+static void test_sof_due()
+{
+    chu_cfg->sof.enabled = 1;
+    chu_cfg->sof.offset_us = 250;
+    sof_update_config();
+    sof_reset_stat();
+
+    sof_frame(10000);
+    CHECK(!sof_due(10100));
+    CHECK(!sof_due(10749));
+    CHECK(sof_due(10750));
+    sof_submitted(10600, 10700); // touch and air publish times
+    CHECK(!sof_due(10800)); // once per frame
+
+    sof_frame(11000);
+    sof_frame(11000); // a queued callback for the same frame
+    const sof_stat_t *stat = sof_stat();
+    CHECK(stat->frames == 2);
+    CHECK(stat->missed == 0);
+    CHECK(stat->age_max_us == 400); // from the older input
+    CHECK(stat->age_min_us == 400);
+
+    sof_frame(12000); // nothing submitted in frame at 11000
+    CHECK(stat->missed == 1);
+
+    CHECK(sof_due(12750));
+    sof_submitted(12700, 12100);
+    sof_frame(13000);
+    CHECK(stat->age_max_us == 900);
+    CHECK(stat->age_min_us == 400);
+
+    CHECK(sof_due(12000 + 3001)); // host stopped sending SOF, run freely
+}
+
+static void test_sof_time()
+{
+    sof_init();
+
+    host_set_time(20000);
+    usb_hw->ints = USB_INTS_DEV_SOF_BITS;
+    host_irq(USBCTRL_IRQ);
+    CHECK(sof_time() == 20000);
+
+    host_set_time(20400);
+    usb_hw->ints = 0; // some other USB interrupt
+    host_irq(USBCTRL_IRQ);
+    CHECK(sof_time() == 20000);
+}
+
+int main()
+{
+    RUN(test_sof_due);
+    RUN(test_sof_time);
+    return test_failures ? 1 : 0;
+}